@@ -0,0 +1,49 @@
+#ifndef ENDSTOP_H
+#define ENDSTOP_H
+
+#include <Arduino.h>
+
+// Active low endstop switch on a pin change interrupt. arm() starts waiting
+// for the switch; the first falling edge after that is latched with its
+// micros() timestamp, so the main loop never has to spin on digitalRead() and
+// can give up after a timeout if the switch never trips. A switch that is
+// already closed when armed counts as tripped at once, as no edge will come.
+// Only pins 8-13 (PCINT0, port B) are supported, and only one Endstop.
+class Endstop {
+ public:
+  // Sets the pin to INPUT_PULLUP and enables its pin change interrupt.
+  // Returns false if the pin is not on PCINT0.
+  bool begin(uint8_t pin);
+
+  // Clears any earlier trip and starts waiting for the next one, or latches
+  // the trip straight away if the switch is already pressed.
+  void arm();
+
+  // Stops waiting for a trip.
+  void disarm() { armed = false; }
+
+  // True once the switch has tripped since arm().
+  bool triggered() const { return hit; }
+
+  // Current level of the switch, regardless of arm().
+  bool isPressed() const { return !(*inputRegister & bitMask); }
+
+  // micros() when arm() was called and when the switch tripped after it, the
+  // same time if it was already pressed.
+  unsigned long armedAt() const;
+  unsigned long triggeredAt() const;
+
+  // Called from the pin change interrupt.
+  void handleChange();
+
+ private:
+  volatile uint8_t* inputRegister = nullptr;
+  uint8_t bitMask = 0;
+
+  volatile bool armed = false;
+  volatile bool hit = false;
+  volatile unsigned long armTime = 0;
+  volatile unsigned long hitTime = 0;
+};
+
+#endif
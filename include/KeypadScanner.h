@@ -0,0 +1,77 @@
+#ifndef KEYPAD_SCANNER_H
+#define KEYPAD_SCANNER_H
+
+#include <Arduino.h>
+
+#ifndef NO_KEY
+#define NO_KEY '\0'
+#endif
+
+// 4x4 key matrix scanned in the background from the Timer0 compare A
+// interrupt, which fires once per millis() tick without disturbing it. Each
+// tick reads the rows of the column pulled low on the tick before, straight
+// from the port, then moves on to the next column, so every key is sampled
+// about every 4 ms. Each key has a counter that every sample moves up if the
+// key reads down and back if it reads up; the key is pressed when the counter
+// reaches debounceSamples and released when it gets back to 0. Presses and
+// releases go into a ring buffer, which the interrupt only adds to and the
+// main loop only takes from, so neither side has to turn interrupts off.
+// Only one KeypadScanner, and Timer0 output compare A (PWM on pin 6) is
+// taken.
+class KeypadScanner {
+ public:
+  static const uint8_t rows = 4;
+  static const uint8_t cols = 4;
+  static const uint8_t debounceSamples = 4;  // about 16 ms
+  static const uint8_t queueLength = 16;
+
+  struct Event {
+    char key;
+    bool pressed;  // false when released
+  };
+
+  // keymap[row][col]; rows are read with pull ups, columns pulled low in turn.
+  KeypadScanner(const char (*keymap)[cols], const uint8_t* rowPins,
+                const uint8_t* colPins);
+
+  // Sets up the pins and starts scanning.
+  void begin();
+
+  // Takes the oldest event from the queue. Returns false if it is empty.
+  bool getEvent(Event* event);
+
+  // Takes events until a press and returns its key, or NO_KEY once the
+  // queue is empty.
+  char getKey();
+
+  // Drops everything queued, e.g. keys pressed during a job.
+  void clear() { tail = head; }
+
+  // Called from the timer interrupt.
+  void scan();
+
+ private:
+  static const uint8_t releasedFlag = 0x80;  // in a queued event
+
+  void push(uint8_t event);
+
+  const char (*keymap)[cols];
+  const uint8_t* rowPins;
+  const uint8_t* colPins;
+
+  volatile uint8_t* rowInput[rows];
+  uint8_t rowMask[rows];
+  volatile uint8_t* colOutput[cols];
+  volatile uint8_t* colMode[cols];
+  uint8_t colMask[cols];
+
+  uint8_t column = 0;                   // pulled low since the last tick
+  uint8_t counts[rows * cols] = {};     // 0 up, debounceSamples down
+  uint16_t held = 0;                    // debounced state, bit per key
+
+  volatile uint8_t events[queueLength];
+  volatile uint8_t head = 0;  // written by the interrupt
+  volatile uint8_t tail = 0;  // written by the main loop
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef LCD_BUFFER_H
+#define LCD_BUFFER_H
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+
+// 16x2 shadow of the LCD. Text is printed into the buffer, which also keeps
+// what the display shows, and flush() sends only the cells that changed: one
+// setCursor() and a burst of characters for each run of them. Redrawing a
+// screen where only a counter moved then costs a few characters instead of a
+// clear() (2 ms) and every character again.
+class LcdBuffer : public Print {
+ public:
+  static const uint8_t cols = 16;
+  static const uint8_t rows = 2;
+
+  explicit LcdBuffer(LiquidCrystal* lcd);
+
+  // Blanks the buffer. Nothing is sent until flush().
+  void clear();
+
+  void setCursor(uint8_t col, uint8_t row);
+
+  // Writes at the cursor; characters past the end of the row are dropped.
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  // Forgets what the display shows, so the next flush() sends every cell.
+  // Needed after anything else has written to the LCD.
+  void invalidate() { stale = true; }
+
+  // Sends the cells that differ from what the display shows. With the LCD in
+  // queued mode this only queues them, and poll() has to be called until
+  // they are out.
+  void flush();
+
+  // Sends queued writes, see LiquidCrystal::setQueued().
+  void poll() { lcd->poll(); }
+
+ private:
+  LiquidCrystal* lcd;
+  char text[rows][cols];
+  char shown[rows][cols];
+  bool stale = true;
+  uint8_t col = 0;
+  uint8_t row = 0;
+};
+
+#endif
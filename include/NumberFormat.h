@@ -0,0 +1,24 @@
+#ifndef NUMBER_FORMAT_H
+#define NUMBER_FORMAT_H
+
+#include <Arduino.h>
+
+// Decimal numbers for the LCD and serial without Print::print(), which
+// divides by 10 for every digit and builds the text in a buffer first. Digits
+// come from subtracting constant powers of ten and go straight to the stream,
+// right aligned in a field of fixed width, so a counter that grows overwrites
+// its old digits instead of needing them blanked out.
+
+// Number of decimal digits in value, 1 for 0.
+uint8_t decimalDigits(uint16_t value);
+uint8_t decimalDigits(uint32_t value);
+
+// Prints value right aligned in width characters, padded on the left with
+// pad. A width of 0 prints just the digits. A value with more digits than
+// width fills the field with '#' instead. Returns the characters printed.
+size_t printFixed(Print& out, uint16_t value, uint8_t width = 0,
+                  char pad = ' ');
+size_t printFixed(Print& out, uint32_t value, uint8_t width = 0,
+                  char pad = ' ');
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef SERVO_MOTION_H
+#define SERVO_MOTION_H
+
+#include <Arduino.h>
+#include <Servo.h>
+
+// Non-blocking servo moves made of constant speed phases, e.g. a fast approach,
+// a slow pass through the material and a fast return. Each phase is handed to
+// the servo interrupt with Servo::writeTicks(), which steps the pulse width
+// every frame; update() only has to be called often enough to start the next
+// phase when one finishes. Speeds are converted at the refresh interval set
+// when the phase starts.
+class ServoMotion {
+ public:
+  static const uint8_t maxPhases = 4;
+
+  explicit ServoMotion(Servo* servo);
+
+  // Sets the pulse width the servo is at now, writing it to the servo.
+  void begin(uint16_t pulseUs);
+
+  // Queues a phase that moves to targetUs at speed microseconds of pulse width
+  // per second. A speed of 0 jumps straight to the target, leaving the servo
+  // to move as fast as it can. Returns false if maxPhases are already queued.
+  bool addPhase(uint16_t targetUs, uint16_t speed);
+
+  // Stops after the phase running now and drops the rest.
+  void clear();
+
+  // Stops where the servo is now and drops all phases.
+  void stop();
+
+  // Starts the next phase once the servo has finished the running one.
+  // Returns true while phases remain.
+  bool update();
+
+  bool isMoving() const { return count > 0; }
+
+  // Pulse width the servo is at now.
+  uint16_t position() const;
+
+ private:
+  struct Phase {
+    uint16_t target;
+    uint16_t speed;
+  };
+
+  void startPhase();
+
+  Servo* servo;
+  Phase phases[maxPhases];
+  uint8_t head = 0;
+  uint8_t count = 0;
+
+  bool phaseStarted = false;
+};
+
+#endif
@@ -5,6 +5,62 @@
 
 #include "AccelStepper.h"
 
+#if defined(ACCELSTEPPER_USE_TIMER) && defined(ARDUINO_ARCH_AVR)
+// Hardware step timer. The timer runs in CTC mode: each compare match either loads
+// the next chunk of a step interval that is too long to count in one go, or issues a step.
+// In pulse mode compare B is armed as a one-shot to end each step pulse.
+#include <util/atomic.h>
+
+#if ACCELSTEPPER_USE_TIMER == 1
+ #define STEP_TIMER_PRESCALE   8
+ #define STEP_TIMER_MAX_TICKS  65536UL
+ #define STEP_TIMER_COMPA_vect TIMER1_COMPA_vect
+ #define STEP_TIMER_OCRA       OCR1A
+ #define STEP_TIMER_TCNT       TCNT1
+ #define STEP_TIMER_COMPB_vect TIMER1_COMPB_vect
+ #define STEP_TIMER_OCRB       OCR1B
+ #define STEP_TIMER_START()    { TCCR1A = 0; TCNT1 = 0; TIFR1 = _BV(OCF1A); TIMSK1 |= _BV(OCIE1A); TCCR1B = _BV(WGM12) | _BV(CS11); }
+ #define STEP_TIMER_STOP()     { TCCR1B = 0; TIMSK1 &= ~(_BV(OCIE1A) | _BV(OCIE1B)); }
+ #define STEP_TIMER_PULSE_ARM()    { TIFR1 = _BV(OCF1B); TIMSK1 |= _BV(OCIE1B); }
+ #define STEP_TIMER_PULSE_DISARM() { TIMSK1 &= ~_BV(OCIE1B); }
+#elif ACCELSTEPPER_USE_TIMER == 2
+ #define STEP_TIMER_PRESCALE   32
+ #define STEP_TIMER_MAX_TICKS  256UL
+ #define STEP_TIMER_COMPA_vect TIMER2_COMPA_vect
+ #define STEP_TIMER_OCRA       OCR2A
+ #define STEP_TIMER_TCNT       TCNT2
+ #define STEP_TIMER_COMPB_vect TIMER2_COMPB_vect
+ #define STEP_TIMER_OCRB       OCR2B
+ #define STEP_TIMER_START()    { TCCR2A = _BV(WGM21); TCNT2 = 0; TIFR2 = _BV(OCF2A); TIMSK2 |= _BV(OCIE2A); TCCR2B = _BV(CS21) | _BV(CS20); }
+ #define STEP_TIMER_STOP()     { TCCR2B = 0; TIMSK2 &= ~(_BV(OCIE2A) | _BV(OCIE2B)); }
+ #define STEP_TIMER_PULSE_ARM()    { TIFR2 = _BV(OCF2B); TIMSK2 |= _BV(OCIE2B); }
+ #define STEP_TIMER_PULSE_DISARM() { TIMSK2 &= ~_BV(OCIE2B); }
+#else
+ #error "ACCELSTEPPER_USE_TIMER must be 1 or 2"
+#endif
+
+#define STEP_TIMER
+#define usToStepTimerTicks(_us) (((_us) * (F_CPU / 1000000UL)) / STEP_TIMER_PRESCALE)
+
+// Members touched by the timer interrupt are only accessed atomically from the main context
+#define ACCELSTEPPER_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+
+// The stepper currently attached to the step timer
+static AccelStepperCore* timerStepper = 0;
+
+ISR(STEP_TIMER_COMPA_vect)
+{
+    timerStepper->timerInterrupt();
+}
+
+ISR(STEP_TIMER_COMPB_vect)
+{
+    timerStepper->timerPulseInterrupt();
+}
+#else
+ #define ACCELSTEPPER_ATOMIC
+#endif
+
 #if 0
 // Some debugging assistance
 void dump(uint8_t* p, int l)
@@ -20,25 +76,47 @@ void dump(uint8_t* p, int l)
 }
 #endif
 
-void AccelStepper::moveTo(long absolute)
+void AccelStepperCore::moveTo(long absolute)
 {
-    if (_targetPos != absolute)
+    ACCELSTEPPER_ATOMIC
     {
-	_targetPos = absolute;
-	computeNewSpeed();
-	// compute new n?
+	if (_targetPos != absolute)
+	{
+	    _targetPos = absolute;
+	    computeNewSpeed();
+	    // compute new n?
+#ifdef STEP_TIMER
+	    if (_timerAttached && _timerDone && _stepInterval)
+	    {
+		// Timer is idle: take the first step straight away, like run() would
+		_timerDone = false;
+		_timerTicksLeft = 0;
+		STEP_TIMER_OCRA = 1;
+		STEP_TIMER_START();
+	    }
+#endif
+	}
     }
 }
 
-void AccelStepper::move(long relative)
+void AccelStepperCore::move(long relative)
 {
-    moveTo(_currentPos + relative);
+    moveTo(currentPosition() + relative);
 }
 
 // Implements steps according to the current step interval
 // You must call this at least once per step
 // returns true if a step occurred
-boolean AccelStepper::runSpeed()
+boolean AccelStepperCore::runSpeed()
+{
+    if (!stepDue())
+	return false;
+    _stepFunction(this, _currentPos);
+    return true;
+}
+
+// Advances position and step time if a step is due, the caller does the step
+boolean AccelStepperCore::stepDue()
 {
     // Dont do anything unless we actually have a step interval
     if (!_stepInterval)
@@ -57,9 +135,25 @@ boolean AccelStepper::runSpeed()
 	    // Anticlockwise  
 	    _currentPos -= 1;
 	}
-	step(_currentPos);
 
-	_lastStepTime = time; // Caution: does not account for costs in step()
+	// How long after it was due this step is being taken. The first step after
+	// a stop has nothing to be late against
+	unsigned long lag = time - _lastStepTime - _stepInterval;
+	if (lag && !_stepFromRest)
+	    _lateSteps++;
+
+	if (_maxCatchUp)
+	{
+	    // Schedule from when this step was due, not when it was noticed, so late
+	    // polls and the cost of step() do not push back all the later steps
+	    if (lag >= _stepInterval * _maxCatchUp)
+		_lastStepTime = time; // Too far behind (or starting from rest): start again from now
+	    else
+		_lastStepTime += _stepInterval;
+	}
+	else
+	    _lastStepTime = time; // Caution: does not account for costs in step()
+	_stepFromRest = false;
 
 	return true;
     }
@@ -69,41 +163,68 @@ boolean AccelStepper::runSpeed()
     }
 }
 
-long AccelStepper::distanceToGo()
+long AccelStepperCore::distanceToGo()
 {
-    return _targetPos - _currentPos;
+    long distance;
+    ACCELSTEPPER_ATOMIC
+    {
+	distance = _targetPos - _currentPos;
+    }
+    return distance;
 }
 
-long AccelStepper::targetPosition()
+long AccelStepperCore::targetPosition()
 {
     return _targetPos;
 }
 
-long AccelStepper::currentPosition()
+long AccelStepperCore::currentPosition()
 {
-    return _currentPos;
+    long position;
+    ACCELSTEPPER_ATOMIC
+    {
+	position = _currentPos;
+    }
+    return position;
 }
 
 // Useful during initialisations or after initial positioning
 // Sets speed to 0
-void AccelStepper::setCurrentPosition(long position)
+void AccelStepperCore::setCurrentPosition(long position)
 {
     _targetPos = _currentPos = position;
     _n = 0;
     _stepInterval = 0;
+    _stepFromRest = true;
     _speed = 0.0;
+    _sCurveAccel = 0.0;
 }
 
-void AccelStepper::computeNewSpeed()
+void AccelStepperCore::computeNewSpeed()
 {
+    if (_jerk != 0.0)
+    {
+	computeNewSpeedSCurve();
+	return;
+    }
+
     long distanceTo = distanceToGo(); // +ve is clockwise from curent location
 
+#ifdef ACCELSTEPPER_FIXED_POINT
+    // Equation 16 without the float maths: when ramping from or to rest, v^2 / 2a is
+    // what the step counter has been counting all along
+    long stepsToStop = (_n > 0) ? _n - 1 : -_n;
+    if (stepsToStop > _stepsToStopMax)
+	stepsToStop = _stepsToStopMax; // Cruising at max speed
+#else
     long stepsToStop = (long)((_speed * _speed) / (2.0 * _acceleration)); // Equation 16
+#endif
 
     if (distanceTo == 0 && stepsToStop <= 1)
     {
 	// We are at the target and its time to stop
 	_stepInterval = 0;
+	_stepFromRest = true;
 	_speed = 0.0;
 	_n = 0;
 	return;
@@ -145,12 +266,44 @@ void AccelStepper::computeNewSpeed()
     }
 
     // Need to accelerate or decelerate
+    unsigned long tableInterval = rampTableInterval();
+#ifdef ACCELSTEPPER_FIXED_POINT
+    if (_n == 0)
+    {
+	// First step from stopped
+	_cnFixed = _c0Fixed;
+	_direction = (distanceTo > 0) ? DIRECTION_CW : DIRECTION_CCW;
+    }
+    else if (tableInterval)
+    {
+	_cnFixed = max(tableInterval << _fixedShift, _cminFixed);
+    }
+    else
+    {
+	// Subsequent step. Works for accel (n is +_ve) and decel (n is -ve).
+	// Rounded to nearest on the magnitude, so deceleration rounds the same way as acceleration
+	unsigned long cn = _cnFixed;
+	long d = (4 * _n) + 1;
+	unsigned long dn = labs(d);
+	unsigned long change = (2 * cn + dn / 2) / dn; // Equation 13
+	cn = (d > 0) ? cn - change : cn + change;
+	_cnFixed = max(cn, _cminFixed);
+    }
+    _n++;
+    _stepInterval = _cnFixed >> _fixedShift;
+    // Only the sign is kept while ramping, speed() works out the magnitude
+    _speed = (_direction == DIRECTION_CCW) ? -1.0 : 1.0;
+#else
     if (_n == 0)
     {
 	// First step from stopped
 	_cn = _c0;
 	_direction = (distanceTo > 0) ? DIRECTION_CW : DIRECTION_CCW;
     }
+    else if (tableInterval)
+    {
+	_cn = max((float)tableInterval, _cmin);
+    }
     else
     {
 	// Subsequent step. Works for accel (n is +_ve) and decel (n is -ve).
@@ -162,6 +315,7 @@ void AccelStepper::computeNewSpeed()
     _speed = 1000000.0 / _cn;
     if (_direction == DIRECTION_CCW)
 	_speed = -_speed;
+#endif
 
 #if 0
     Serial.println(_speed);
@@ -176,20 +330,172 @@ void AccelStepper::computeNewSpeed()
 #endif
 }
 
+// Jerk limited version of computeNewSpeed(). Works on the speed and acceleration along the
+// direction of travel: the acceleration moves towards its target by at most jerk * dt per step,
+// and the target is chosen so that both the speed and the acceleration reach 0 together at the
+// target position
+void AccelStepperCore::computeNewSpeedSCurve()
+{
+    long distanceTo = distanceToGo(); // +ve is clockwise from curent location
+    float v = fabs(_speed);
+
+    if (v == 0.0)
+    {
+	if (distanceTo == 0)
+	{
+	    _stepInterval = 0;
+	    return;
+	}
+	// First step from stopped, at the speed that covers one step from rest at constant jerk
+	_direction = (distanceTo > 0) ? DIRECTION_CW : DIRECTION_CCW;
+	_sCurveAccel = 0.0;
+	v = _sCurveMinSpeed;
+    }
+    else if (_currentPos == _sCurvePos)
+    {
+	// No step since the last update, eg a new target: carry on at the current speed
+	// and acceleration until the next step, which plans for the new target
+	return;
+    }
+    else
+    {
+	long remaining = (_direction == DIRECTION_CW) ? distanceTo : -distanceTo;
+	float stepsToStop = sCurveStepsToStop(v, _sCurveAccel);
+
+	if (distanceTo == 0 && stepsToStop <= 1.0)
+	{
+	    // We are at the target and its time to stop
+	    _stepInterval = 0;
+	    _stepFromRest = true;
+	    _speed = 0.0;
+	    _sCurveAccel = 0.0;
+	    _n = 0;
+	    return;
+	}
+
+	float da = _jerk * _stepInterval / 1000000.0; // Jerk over the step just taken
+	float target;
+	if (remaining <= 0 || stepsToStop >= remaining)
+	{
+	    // Decelerate, easing off at the end so that acceleration and speed reach 0 together
+	    if (_sCurveAccel < 0.0 && v <= (_sCurveAccel * _sCurveAccel) / (2.0 * _jerk))
+		target = 0.0;
+	    else
+		target = -_acceleration;
+	}
+	else if (v >= _maxSpeed)
+	    target = 0.0; // Cruising
+	else if (sCurveStepsToStop(v, min(max(_sCurveAccel, 0.0) + da, _acceleration)) + 1.0 >= remaining)
+	    target = 0.0; // Too close to the target to speed up any more: creep in
+	else
+	    target = _acceleration;
+
+	if (_sCurveAccel < target)
+	    _sCurveAccel = min(_sCurveAccel + da, target);
+	else
+	    _sCurveAccel = max(_sCurveAccel - da, target);
+	if (_sCurveAccel > 0.0)
+	{
+	    // Ease into max speed. Easing off from a by da per step gains (a^2 + a * da) / 2j
+	    // before a gets to 0, so hold a to the value that lands on max speed just as it
+	    // does, instead of clamping the speed with acceleration left over
+	    float gap = (v < _maxSpeed) ? _maxSpeed - v : 0.0;
+	    float easeIn = (sqrt((da * da) + (8.0 * _jerk * gap)) - da) / 2.0;
+	    if (easeIn < da / 2.0)
+	    {
+		_sCurveAccel = 0.0; // Less than half a step of jerk to go
+		v = _maxSpeed;
+	    }
+	    else
+		_sCurveAccel = min(_sCurveAccel, easeIn);
+	}
+	// Constant acceleration over the next step: v^2 = u^2 + 2as, with s = 1 step
+	float vv = (v * v) + (2.0 * _sCurveAccel);
+	v = min(vv > 0.0 ? sqrt(vv) : 0.0, _maxSpeed);
+
+	if (v < _sCurveMinSpeed)
+	{
+	    // Slowest speed we ever move at. If we were heading away from
+	    // the target, this is where we turn round
+	    v = _sCurveMinSpeed;
+	    _sCurveAccel = 0.0;
+	    if (remaining <= 0)
+		_direction = (distanceTo > 0) ? DIRECTION_CW : DIRECTION_CCW;
+	}
+    }
+    _n++;
+    _sCurvePos = _currentPos;
+    _stepInterval = 1000000.0 / v;
+    _speed = (_direction == DIRECTION_CW) ? v : -v;
+}
+
+float AccelStepperCore::sCurveStepsToStop(float v, float a)
+{
+    float steps = 0.0;
+    if (a > 0.0)
+    {
+	// Still accelerating: speed keeps rising while the acceleration ramps down to 0
+	float t = a / _jerk;
+	steps = (v * t) + (a * t * t / 3.0);
+	v += (a * a) / (2.0 * _jerk);
+    }
+    if (v * _jerk >= _acceleration * _acceleration)
+	steps += v * ((v / _acceleration) + (_acceleration / _jerk)) / 2.0; // Reaches full deceleration
+    else
+	steps += v * sqrt(v / _jerk); // Deceleration ramps up and straight back down
+    return steps;
+}
+
+void AccelStepperCore::setJerk(float jerk)
+{
+    if (jerk < 0.0)
+	jerk = -jerk;
+    _jerk = jerk;
+    // One step from rest under constant jerk takes t = cbrt(6 / jerk)
+    if (jerk != 0.0)
+	_sCurveMinSpeed = 1.0 / pow(6.0 / jerk, 1.0 / 3.0);
+    _sCurveAccel = 0.0;
+}
+
+unsigned long AccelStepperCore::rampTableInterval()
+{
+    if (!_rampTable || _n == 0)
+	return 0;
+    // Accelerating with n steps gone, the next step is entry n. Decelerating, _n = -m
+    // takes the speed back down to that of step m - 1, and step 0 is c0
+    long i = (_n > 0) ? _n : -_n - 1;
+    if (i == 0)
+	return _c0;
+    if (i > _rampTableLength)
+	return 0;
+    return pgm_read_word(&_rampTable[i - 1]);
+}
+
+void AccelStepperCore::setRampTable(const uint16_t* table, uint16_t length)
+{
+    _rampTable = table;
+    _rampTableLength = length;
+}
+
 // Run the motor to implement speed and acceleration in order to proceed to the target position
 // You must call this at least once per step, preferably in your main loop
 // If the motor is in the desired position, the cost is very small
 // returns true if the motor is still running to the target position.
-boolean AccelStepper::run()
+boolean AccelStepperCore::run()
 {
+    // When attached to the step timer the interrupt does the stepping
+    if (_timerAttached)
+	return !_timerDone;
     if (runSpeed())
 	computeNewSpeed();
     return _speed != 0.0 || distanceToGo() != 0;
 }
 
-AccelStepper::AccelStepper(uint8_t interface, uint8_t pin1, uint8_t pin2, uint8_t pin3, uint8_t pin4, bool enable)
+AccelStepperCore::AccelStepperCore(StepFunction step, PulseFunction pulseStart, PulseFunction pulseEnd)
 {
-    _interface = interface;
+    _stepFunction = step;
+    _pulseStartFunction = pulseStart;
+    _pulseEndFunction = pulseEnd;
     _currentPos = 0;
     _targetPos = 0;
     _speed = 0.0;
@@ -200,10 +506,7 @@ AccelStepper::AccelStepper(uint8_t interface, uint8_t pin1, uint8_t pin2, uint8_
     _minPulseWidth = 1;
     _enablePin = 0xff;
     _lastStepTime = 0;
-    _pin[0] = pin1;
-    _pin[1] = pin2;
-    _pin[2] = pin3;
-    _pin[3] = pin4;
+    _stepFromRest = true;
     _enableInverted = false;
     
     // NEW
@@ -211,30 +514,57 @@ AccelStepper::AccelStepper(uint8_t interface, uint8_t pin1, uint8_t pin2, uint8_
     _c0 = 0.0;
     _cn = 0.0;
     _cmin = 1.0;
+    _c0Fixed = 0;
+    _cnFixed = 0;
+    _cminFixed = 1;
+    _fixedShift = 0;
+    _stepsToStopMax = 0;
+    _rampTable = 0;
+    _rampTableLength = 0;
+    _jerk = 0.0;
+    _sCurveAccel = 0.0;
+    _sCurveMinSpeed = 1.0;
+    _sCurvePos = 0;
+    _maxCatchUp = 0;
+    _lateSteps = 0;
     _direction = DIRECTION_CCW;
+    _timerAttached = false;
+    _timerDone = true;
+    _timerPulse = false;
+    _pulseHigh = false;
+    _pulseTicksLeft = 0;
+    _timerTicksLeft = 0;
+
+    // Some reasonable default
+    setAcceleration(1);
+}
+
+AccelStepper::AccelStepper(uint8_t interface, uint8_t pin1, uint8_t pin2, uint8_t pin3, uint8_t pin4, bool enable)
+    : AccelStepperCore(&coreStep, (interface == DRIVER) ? &corePulseStart : 0, &corePulseEnd)
+{
+    _interface = interface;
+    _pin[0] = pin1;
+    _pin[1] = pin2;
+    _pin[2] = pin3;
+    _pin[3] = pin4;
 
     int i;
     for (i = 0; i < 4; i++)
+    {
 	_pinInverted[i] = 0;
+#if defined(ARDUINO_ARCH_AVR)
+	_pinPort[i] = portOutputRegister(digitalPinToPort(_pin[i]));
+	_pinMask[i] = digitalPinToBitMask(_pin[i]);
+#endif
+    }
     if (enable)
 	enableOutputs();
-    // Some reasonable default
-    setAcceleration(1);
 }
 
 AccelStepper::AccelStepper(void (*forward)(), void (*backward)())
+    : AccelStepperCore(&coreStep, 0, &corePulseEnd)
 {
     _interface = 0;
-    _currentPos = 0;
-    _targetPos = 0;
-    _speed = 0.0;
-    _maxSpeed = 1.0;
-    _acceleration = 0.0;
-    _sqrt_twoa = 1.0;
-    _stepInterval = 0;
-    _minPulseWidth = 1;
-    _enablePin = 0xff;
-    _lastStepTime = 0;
     _pin[0] = 0;
     _pin[1] = 0;
     _pin[2] = 0;
@@ -242,21 +572,27 @@ AccelStepper::AccelStepper(void (*forward)(), void (*backward)())
     _forward = forward;
     _backward = backward;
 
-    // NEW
-    _n = 0;
-    _c0 = 0.0;
-    _cn = 0.0;
-    _cmin = 1.0;
-    _direction = DIRECTION_CCW;
-
     int i;
     for (i = 0; i < 4; i++)
 	_pinInverted[i] = 0;
-    // Some reasonable default
-    setAcceleration(1);
 }
 
-void AccelStepper::setMaxSpeed(float speed)
+void AccelStepper::coreStep(AccelStepperCore* stepper, long step)
+{
+    static_cast<AccelStepper*>(stepper)->step(step);
+}
+
+void AccelStepper::corePulseStart(AccelStepperCore* stepper)
+{
+    static_cast<AccelStepper*>(stepper)->pulseStart();
+}
+
+void AccelStepper::corePulseEnd(AccelStepperCore* stepper)
+{
+    static_cast<AccelStepper*>(stepper)->pulseEnd();
+}
+
+void AccelStepperCore::setMaxSpeed(float speed)
 {
     if (speed < 0.0)
        speed = -speed;
@@ -264,21 +600,29 @@ void AccelStepper::setMaxSpeed(float speed)
     {
 	_maxSpeed = speed;
 	_cmin = 1000000.0 / speed;
+	_cminFixed = _cmin * (1UL << _fixedShift);
+	_stepsToStopMax = (long)((speed * speed) / (2.0 * _acceleration)); // Equation 16
 	// Recompute _n from current speed and adjust speed if accelerating or cruising
 	if (_n > 0)
 	{
-	    _n = (long)((_speed * _speed) / (2.0 * _acceleration)); // Equation 16
+	    float currentSpeed = this->speed();
+	    _n = (long)((currentSpeed * currentSpeed) / (2.0 * _acceleration)); // Equation 16
 	    computeNewSpeed();
 	}
     }
 }
 
-float   AccelStepper::maxSpeed()
+float   AccelStepperCore::maxSpeed()
 {
     return _maxSpeed;
 }
 
-void AccelStepper::setAcceleration(float acceleration)
+float   AccelStepperCore::acceleration()
+{
+    return _acceleration;
+}
+
+void AccelStepperCore::setAcceleration(float acceleration)
 {
     if (acceleration == 0.0)
 	return;
@@ -290,18 +634,33 @@ void AccelStepper::setAcceleration(float acceleration)
 	_n = _n * (_acceleration / acceleration);
 	// New c0 per Equation 7, with correction per Equation 15
 	_c0 = 0.676 * sqrt(2.0 / acceleration) * 1000000.0; // Equation 15
+	// Use as many fraction bits as c0 leaves room for in 2 * cn
+	uint8_t shift = 16;
+	while (shift && _c0 * (1UL << shift) >= 1073741824.0)
+	    shift--;
+	if (shift > _fixedShift)
+	    _cnFixed <<= shift - _fixedShift;
+	else
+	    _cnFixed >>= _fixedShift - shift;
+	_fixedShift = shift;
+	_c0Fixed = _c0 * (1UL << shift);
+	_cminFixed = _cmin * (1UL << shift);
 	_acceleration = acceleration;
+	_stepsToStopMax = (long)((_maxSpeed * _maxSpeed) / (2.0 * acceleration)); // Equation 16
 	computeNewSpeed();
     }
 }
 
-void AccelStepper::setSpeed(float speed)
+void AccelStepperCore::setSpeed(float speed)
 {
-    if (speed == _speed)
+    if (speed == this->speed())
         return;
     speed = constrain(speed, -_maxSpeed, _maxSpeed);
     if (speed == 0.0)
+    {
 	_stepInterval = 0;
+	_stepFromRest = true;
+    }
     else
     {
 	_stepInterval = fabs(1000000.0 / speed);
@@ -310,8 +669,13 @@ void AccelStepper::setSpeed(float speed)
     _speed = speed;
 }
 
-float AccelStepper::speed()
+float AccelStepperCore::speed()
 {
+#ifdef ACCELSTEPPER_FIXED_POINT
+    // computeNewSpeed() only keeps the sign of _speed, the magnitude follows from the step interval
+    if (_speed != 0.0 && _stepInterval)
+	return (_speed > 0.0) ? 1000000.0 / _stepInterval : -1000000.0 / _stepInterval;
+#endif
     return _speed;
 }
 
@@ -362,8 +726,23 @@ void AccelStepper::setOutputPins(uint8_t mask)
     else if (_interface == FULL3WIRE || _interface == HALF3WIRE)
 	numpins = 3;
     uint8_t i;
+#if defined(ARDUINO_ARCH_AVR)
+    // Single read-modify-write per pin, with interrupts off in case something
+    // else writes the same port from an interrupt
+    uint8_t oldSREG = SREG;
+    cli();
+    for (i = 0; i < numpins; i++)
+    {
+	if (((mask >> i) & 1) ^ _pinInverted[i])
+	    *_pinPort[i] |= _pinMask[i];
+	else
+	    *_pinPort[i] &= ~_pinMask[i];
+    }
+    SREG = oldSREG;
+#else
     for (i = 0; i < numpins; i++)
 	digitalWrite(_pin[i], (mask & (1 << i)) ? (HIGH ^ _pinInverted[i]) : (LOW ^ _pinInverted[i]));
+#endif
 }
 
 // 0 pin step function (ie for functional usage)
@@ -576,12 +955,27 @@ void    AccelStepper::enableOutputs()
     }
 }
 
-void AccelStepper::setMinPulseWidth(unsigned int minWidth)
+void AccelStepperCore::setMaxCatchUp(uint8_t intervals)
+{
+    _maxCatchUp = intervals;
+}
+
+unsigned long AccelStepperCore::lateSteps()
+{
+    return _lateSteps;
+}
+
+void AccelStepperCore::clearLateSteps()
+{
+    _lateSteps = 0;
+}
+
+void AccelStepperCore::setMinPulseWidth(unsigned int minWidth)
 {
     _minPulseWidth = minWidth;
 }
 
-void AccelStepper::setEnablePin(uint8_t enablePin)
+void AccelStepperCore::setEnablePin(uint8_t enablePin)
 {
     _enablePin = enablePin;
 
@@ -610,13 +1004,13 @@ void AccelStepper::setPinsInverted(bool pin1Invert, bool pin2Invert, bool pin3In
 }
 
 // Blocks until the target position is reached and stopped
-void AccelStepper::runToPosition()
+void AccelStepperCore::runToPosition()
 {
     while (run())
 	YIELD; // Let system housekeeping occur
 }
 
-boolean AccelStepper::runSpeedToPosition()
+boolean AccelStepperCore::runSpeedToPosition()
 {
     if (_targetPos == _currentPos)
 	return false;
@@ -628,17 +1022,22 @@ boolean AccelStepper::runSpeedToPosition()
 }
 
 // Blocks until the new target position is reached
-void AccelStepper::runToNewPosition(long position)
+void AccelStepperCore::runToNewPosition(long position)
 {
     moveTo(position);
     runToPosition();
 }
 
-void AccelStepper::stop()
+void AccelStepperCore::stop()
 {
     if (_speed != 0.0)
     {    
-	long stepsToStop = (long)((_speed * _speed) / (2.0 * _acceleration)) + 1; // Equation 16 (+integer rounding)
+	float currentSpeed = speed();
+	long stepsToStop;
+	if (_jerk != 0.0)
+	    stepsToStop = (long)sCurveStepsToStop(fabs(currentSpeed), _sCurveAccel) + 1;
+	else
+	    stepsToStop = (long)((currentSpeed * currentSpeed) / (2.0 * _acceleration)) + 1; // Equation 16 (+integer rounding)
 	if (_speed > 0)
 	    move(stepsToStop);
 	else
@@ -646,7 +1045,185 @@ void AccelStepper::stop()
     }
 }
 
-bool AccelStepper::isRunning()
+bool AccelStepperCore::isRunning()
 {
     return !(_speed == 0.0 && _targetPos == _currentPos);
 }
+
+boolean AccelStepperCore::attachTimer()
+{
+#ifdef STEP_TIMER
+    if (timerStepper && timerStepper != this)
+	return false;
+    timerStepper = this;
+    _timerDone = true;
+    _timerAttached = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AccelStepperCore::detachTimer()
+{
+#ifdef STEP_TIMER
+    if (timerStepper != this)
+	return;
+    ACCELSTEPPER_ATOMIC
+    {
+	STEP_TIMER_STOP();
+	if (_pulseHigh)
+	    endPulse();
+	timerStepper = 0;
+	_timerAttached = false;
+	_timerDone = true;
+    }
+#endif
+}
+
+// Runs in interrupt context on each step timer compare match
+void AccelStepperCore::timerInterrupt()
+{
+#ifdef STEP_TIMER
+    if (_timerTicksLeft)
+    {
+	// Still counting down a step interval longer than one timer cycle
+	loadTimer();
+	loadPulseTimer();
+	return;
+    }
+    if (!_stepInterval)
+    {
+	// Target was reached or changed to where we already are
+	if (_pulseHigh)
+	    endPulse();
+	STEP_TIMER_STOP();
+	_timerDone = true;
+	return;
+    }
+
+    if (_direction == DIRECTION_CW)
+	_currentPos += 1;
+    else
+	_currentPos -= 1;
+    if (_timerPulse)
+    {
+	// Step intervals shorter than the pulse width cut the previous pulse short
+	if (_pulseHigh)
+	    endPulse();
+	_pulseStartFunction(this);
+	_pulseHigh = true;
+	_pulseTicksLeft = usToStepTimerTicks((unsigned long)_minPulseWidth);
+	if (!_pulseTicksLeft)
+	    _pulseTicksLeft = 1;
+    }
+    else
+	_stepFunction(this, _currentPos);
+    computeNewSpeed();
+
+    if (!_stepInterval)
+    {
+	if (_pulseHigh)
+	{
+	    // Keep the timer running until the last pulse is over
+	    _timerTicksLeft = _pulseTicksLeft + 1;
+	    loadTimer();
+	    loadPulseTimer();
+	    return;
+	}
+	STEP_TIMER_STOP();
+	_timerDone = true;
+	return;
+    }
+    // The counter was reset at the compare match, so the interval is measured from
+    // the step itself regardless of how long this interrupt took
+    _timerTicksLeft = usToStepTimerTicks(_stepInterval);
+    loadTimer();
+    loadPulseTimer();
+#endif
+}
+
+// Runs in interrupt context on the step timer compare B match that ends a pulse
+void AccelStepperCore::timerPulseInterrupt()
+{
+#ifdef STEP_TIMER
+    STEP_TIMER_PULSE_DISARM();
+    if (_pulseHigh)
+	endPulse();
+#endif
+}
+
+void AccelStepperCore::endPulse()
+{
+    _pulseEndFunction(this);
+    _pulseHigh = false;
+}
+
+void AccelStepperCore::loadPulseTimer()
+{
+#ifdef STEP_TIMER
+    if (!_pulseHigh)
+	return;
+    // Compare B only matches if it is within the chunk just loaded into compare A. If not,
+    // count the chunk off the pulse and look again at the next compare A match
+    unsigned long top = STEP_TIMER_OCRA;
+    unsigned long now = STEP_TIMER_TCNT + 1;
+    unsigned long ticks = (_pulseTicksLeft > now) ? _pulseTicksLeft : now;
+    if (ticks <= top)
+    {
+	STEP_TIMER_OCRB = ticks;
+	STEP_TIMER_PULSE_ARM();
+    }
+    else
+	_pulseTicksLeft = (_pulseTicksLeft > top + 1) ? _pulseTicksLeft - (top + 1) : 1;
+#endif
+}
+
+boolean AccelStepperCore::setTimerPulse(bool enable)
+{
+#ifdef STEP_TIMER
+    if (enable && !_pulseStartFunction)
+	return false;
+    ACCELSTEPPER_ATOMIC
+    {
+	if (_pulseHigh)
+	{
+	    STEP_TIMER_PULSE_DISARM();
+	    endPulse();
+	}
+	_timerPulse = enable;
+    }
+    return true;
+#else
+    return !enable;
+#endif
+}
+
+// Sets the direction and raises the step pin, as the first half of step1()
+void AccelStepper::pulseStart()
+{
+    // _pin[0] is step, _pin[1] is direction
+    setOutputPins(_direction ? 0b10 : 0b00); // Set direction first else get rogue pulses
+    setOutputPins(_direction ? 0b11 : 0b01); // step HIGH
+}
+
+// Lowers the step pin, as the end of step1()
+void AccelStepper::pulseEnd()
+{
+    setOutputPins(_direction ? 0b10 : 0b00); // step LOW
+}
+
+void AccelStepperCore::loadTimer()
+{
+#ifdef STEP_TIMER
+    unsigned long ticks = _timerTicksLeft;
+    // Split long intervals so the last chunk is never too short to be caught
+    if (ticks > STEP_TIMER_MAX_TICKS)
+	ticks = (ticks < 2 * STEP_TIMER_MAX_TICKS) ? ticks / 2 : STEP_TIMER_MAX_TICKS;
+    _timerTicksLeft -= ticks;
+    // If we are already past the compare value the counter would run all the way round
+    // before matching, so step as soon as possible instead
+    unsigned long now = STEP_TIMER_TCNT + 1;
+    STEP_TIMER_OCRA = (ticks > now) ? ticks - 1 : now;
+#endif
+}
@@ -277,111 +277,19 @@
 #endif
 
 /////////////////////////////////////////////////////////////////////
-/// \class AccelStepper AccelStepper.h <AccelStepper.h>
-/// \brief Support for stepper motors with acceleration etc.
-///
-/// This defines a single 2 or 4 pin stepper motor, or stepper moter with fdriver chip, with optional
-/// acceleration, deceleration, absolute positioning commands etc. Multiple
-/// simultaneous steppers are supported, all moving 
-/// at different speeds and accelerations. 
-///
-/// \par Operation
-/// This module operates by computing a step time in microseconds. The step
-/// time is recomputed after each step and after speed and acceleration
-/// parameters are changed by the caller. The time of each step is recorded in
-/// microseconds. The run() function steps the motor once if a new step is due.
-/// The run() function must be called frequently until the motor is in the
-/// desired position, after which time run() will do nothing.
-///
-/// \par Positioning
-/// Positions are specified by a signed long integer. At
-/// construction time, the current position of the motor is consider to be 0. Positive
-/// positions are clockwise from the initial position; negative positions are
-/// anticlockwise. The current position can be altered for instance after
-/// initialization positioning.
-///
-/// \par Caveats
-/// This is an open loop controller: If the motor stalls or is oversped,
-/// AccelStepper will not have a correct 
-/// idea of where the motor really is (since there is no feedback of the motor's
-/// real position. We only know where we _think_ it is, relative to the
-/// initial starting point).
-///
-/// \par Performance
-/// The fastest motor speed that can be reliably supported is about 4000 steps per
-/// second at a clock frequency of 16 MHz on Arduino such as Uno etc. 
-/// Faster processors can support faster stepping speeds. 
-/// However, any speed less than that
-/// down to very slow speeds (much less than one per second) are also supported,
-/// provided the run() function is called frequently enough to step the motor
-/// whenever required for the speed set.
-/// Calling setAcceleration() is expensive,
-/// since it requires a square root to be calculated.
+/// \class AccelStepperCore AccelStepper.h <AccelStepper.h>
+/// \brief The motion side of AccelStepper, without the motor outputs
 ///
-/// Gregor Christandl reports that with an Arduino Due and a simple test program, 
-/// he measured 43163 steps per second using runSpeed(), 
-/// and 16214 steps per second using run();
-class AccelStepper
+/// AccelStepperCore keeps the position, speed, acceleration ramps and step timer, and
+/// works out when each step is due. The steps themselves are issued through the step
+/// functions given to its constructor by the class deriving from it: AccelStepper for
+/// motors wired up at run time, or AccelStepperT for an interface and pins fixed at
+/// compile time. AccelStepperCore has no virtual functions, so a sketch that only uses
+/// AccelStepperT does not link in the AccelStepper step functions or its vtable.
+/// AccelStepperQueue runs on either through an AccelStepperCore reference.
+class AccelStepperCore
 {
 public:
-    /// \brief Symbolic names for number of pins.
-    /// Use this in the pins argument the AccelStepper constructor to 
-    /// provide a symbolic name for the number of pins
-    /// to use.
-    typedef enum
-    {
-	FUNCTION  = 0, ///< Use the functional interface, implementing your own driver functions (internal use only)
-	DRIVER    = 1, ///< Stepper Driver, 2 driver pins required
-	FULL2WIRE = 2, ///< 2 wire stepper, 2 motor pins required
-	FULL3WIRE = 3, ///< 3 wire stepper, such as HDD spindle, 3 motor pins required
-        FULL4WIRE = 4, ///< 4 wire full stepper, 4 motor pins required
-	HALF3WIRE = 6, ///< 3 wire half stepper, such as HDD spindle, 3 motor pins required
-	HALF4WIRE = 8  ///< 4 wire half stepper, 4 motor pins required
-    } MotorInterfaceType;
-
-    /// Constructor. You can have multiple simultaneous steppers, all moving
-    /// at different speeds and accelerations, provided you call their run()
-    /// functions at frequent enough intervals. Current Position is set to 0, target
-    /// position is set to 0. MaxSpeed and Acceleration default to 1.0.
-    /// The motor pins will be initialised to OUTPUT mode during the
-    /// constructor by a call to enableOutputs().
-    /// \param[in] interface Number of pins to interface to. Integer values are
-    /// supported, but it is preferred to use the \ref MotorInterfaceType symbolic names. 
-    /// AccelStepper::DRIVER (1) means a stepper driver (with Step and Direction pins).
-    /// If an enable line is also needed, call setEnablePin() after construction.
-    /// You may also invert the pins using setPinsInverted().
-    /// Caution: DRIVER implements a blocking delay of minPulseWidth microseconds (default 1us) for each step.
-    /// You can change this with setMinPulseWidth().
-    /// AccelStepper::FULL2WIRE (2) means a 2 wire stepper (2 pins required). 
-    /// AccelStepper::FULL3WIRE (3) means a 3 wire stepper, such as HDD spindle (3 pins required). 
-    /// AccelStepper::FULL4WIRE (4) means a 4 wire stepper (4 pins required). 
-    /// AccelStepper::HALF3WIRE (6) means a 3 wire half stepper, such as HDD spindle (3 pins required)
-    /// AccelStepper::HALF4WIRE (8) means a 4 wire half stepper (4 pins required)
-    /// Defaults to AccelStepper::FULL4WIRE (4) pins.
-    /// \param[in] pin1 Arduino digital pin number for motor pin 1. Defaults
-    /// to pin 2. For a AccelStepper::DRIVER (interface==1), 
-    /// this is the Step input to the driver. Low to high transition means to step)
-    /// \param[in] pin2 Arduino digital pin number for motor pin 2. Defaults
-    /// to pin 3. For a AccelStepper::DRIVER (interface==1), 
-    /// this is the Direction input the driver. High means forward.
-    /// \param[in] pin3 Arduino digital pin number for motor pin 3. Defaults
-    /// to pin 4.
-    /// \param[in] pin4 Arduino digital pin number for motor pin 4. Defaults
-    /// to pin 5.
-    /// \param[in] enable If this is true (the default), enableOutputs() will be called to enable
-    /// the output pins at construction time.
-    AccelStepper(uint8_t interface = AccelStepper::FULL4WIRE, uint8_t pin1 = 2, uint8_t pin2 = 3, uint8_t pin3 = 4, uint8_t pin4 = 5, bool enable = true);
-
-    /// Alternate Constructor which will call your own functions for forward and backward steps. 
-    /// You can have multiple simultaneous steppers, all moving
-    /// at different speeds and accelerations, provided you call their run()
-    /// functions at frequent enough intervals. Current Position is set to 0, target
-    /// position is set to 0. MaxSpeed and Acceleration default to 1.0.
-    /// Any motor initialization should happen before hand, no pins are used or initialized.
-    /// \param[in] forward void-returning procedure that will make a forward step
-    /// \param[in] backward void-returning procedure that will make a backward step
-    AccelStepper(void (*forward)(), void (*backward)());
-    
     /// Set the target position. The run() function will try to move the motor (at most one step per call)
     /// from the current position to the target position set by the most
     /// recent call to this function. Caution: moveTo() also recalculates the speed for the next step. 
@@ -429,6 +337,22 @@ public:
     /// root to be calculated. Dont call more ofthen than needed
     void    setAcceleration(float acceleration);
 
+    /// Returns the acceleration/deceleration rate configured for this stepper
+    /// that was previously set by setAcceleration();
+    /// \return The currently configured acceleration/deceleration
+    float   acceleration();
+
+    /// Sets the jerk limit for S-curve motion profiles. With a jerk limit set,
+    /// run() no longer changes the acceleration in one step at the start and end of
+    /// each ramp: the acceleration itself ramps up and down at no more than jerk,
+    /// up to the acceleration set by setAcceleration(). This gives smoother starts
+    /// and stops for the same peak acceleration, at the cost of slightly longer ramps and
+    /// float maths on every step (setRampTable() and ACCELSTEPPER_FIXED_POINT only apply to
+    /// trapezoidal profiles).
+    /// \param[in] jerk The maximum rate of change of acceleration in steps per second
+    /// per second per second. 0.0 (the default) gives the usual trapezoidal profiles.
+    void    setJerk(float jerk);
+
     /// Sets the desired constant speed for use with runSpeed().
     /// \param[in] speed The desired constant speed in steps per
     /// second. Positive is clockwise. Speeds of more than 1000 steps per
@@ -486,19 +410,29 @@ public:
     /// to stop as quickly as possible, using the current speed and acceleration parameters.
     void stop();
 
-    /// Disable motor pin outputs by setting them all LOW
-    /// Depending on the design of your electronics this may turn off
-    /// the power to the motor coils, saving power.
-    /// This is useful to support Arduino low power modes: disable the outputs
-    /// during sleep and then reenable with enableOutputs() before stepping
-    /// again.
-    /// If the enable Pin is defined, sets it to OUTPUT mode and clears the pin to disabled.
-    virtual void    disableOutputs();
-
-    /// Enable motor pin outputs by setting the motor pins to OUTPUT
-    /// mode. Called automatically by the constructor.
-    /// If the enable Pin is defined, sets it to OUTPUT mode and sets the pin to enabled.
-    virtual void    enableOutputs();
+    /// Selects how runSpeed() schedules steps. By default (0) each step interval is
+    /// timed from when the previous step was actually taken, so every late call to run() or
+    /// runSpeed(), and the time taken by step() itself, pushes all the later steps back and the
+    /// motor runs slower than commanded. With intervals > 0 each step is timed from when
+    /// the previous step was due instead, and a caller that falls behind gets the missed
+    /// steps back as quickly as it polls, as long as it is less than intervals step intervals
+    /// behind. Further behind than that (including when starting from rest), the schedule
+    /// restarts from the current time.
+    /// Has no effect on steps generated by the step timer, which are already drift free.
+    /// \param[in] intervals Maximum lag in step intervals to catch up on, 0 for the original behaviour.
+    void    setMaxCatchUp(uint8_t intervals);
+
+    /// Returns the number of steps runSpeed() has issued any time after they were due,
+    /// since construction or clearLateSteps(). A step is due one step interval after the
+    /// previous one was due with setMaxCatchUp() > 0, or after it was taken with the default
+    /// of 0. The first step after the stepper has stopped is never counted.
+    /// Polling can only catch a step the next time run() is called, so some late steps
+    /// are normal; a count that keeps pace with the steps taken means the loop is too slow.
+    /// \return The number of late steps
+    unsigned long lateSteps();
+
+    /// Resets the count returned by lateSteps() to 0
+    void    clearLateSteps();
 
     /// Sets the minimum pulse width allowed by the stepper driver. The minimum practical pulse width is 
     /// approximately 20 microseconds. Times less than 20 microseconds
@@ -515,25 +449,71 @@ public:
     /// \sa setPinsInverted
     void    setEnablePin(uint8_t enablePin = 0xff);
 
-    /// Sets the inversion for stepper driver pins
-    /// \param[in] directionInvert True for inverted direction pin, false for non-inverted
-    /// \param[in] stepInvert      True for inverted step pin, false for non-inverted
-    /// \param[in] enableInvert    True for inverted enable pin, false (default) for non-inverted
-    void    setPinsInverted(bool directionInvert = false, bool stepInvert = false, bool enableInvert = false);
-
-    /// Sets the inversion for 2, 3 and 4 wire stepper pins
-    /// \param[in] pin1Invert True for inverted pin1, false for non-inverted
-    /// \param[in] pin2Invert True for inverted pin2, false for non-inverted
-    /// \param[in] pin3Invert True for inverted pin3, false for non-inverted
-    /// \param[in] pin4Invert True for inverted pin4, false for non-inverted
-    /// \param[in] enableInvert    True for inverted enable pin, false (default) for non-inverted
-    void    setPinsInverted(bool pin1Invert, bool pin2Invert, bool pin3Invert, bool pin4Invert, bool enableInvert);
-
     /// Checks to see if the motor is currently running to a target
     /// \return true if the speed is not zero or not at the target position
     bool    isRunning();
 
+    /// Sets a table of precomputed step intervals for the acceleration ramp, usually
+    /// generated at compile time with AccelStepperRamp (see AccelStepperRamp.h).
+    /// While accelerating and decelerating, the interval for each step is then read from the
+    /// table by step number instead of being computed with Equation 13, which leaves a single
+    /// flash read per step. Steps beyond the end of the table are computed as usual.
+    /// The table must have been generated for the acceleration set with setAcceleration().
+    /// \param[in] table Step intervals in microseconds for steps 1, 2, 3 ... of a ramp from rest,
+    /// stored in program memory (PROGMEM). 0 (the default) returns to computing every step.
+    /// \param[in] length Number of entries in table
+    void    setRampTable(const uint16_t* table = 0, uint16_t length = 0);
+
+    /// Hands step generation for this stepper over to the hardware step timer selected
+    /// at compile time with ACCELSTEPPER_USE_TIMER (1 for Timer1, 2 for Timer2, AVR only).
+    /// From then on the timer compare interrupt issues each step and loads the next
+    /// step interval from computeNewSpeed(), so step timing no longer depends on how often
+    /// run() is called. moveTo(), move() and stop() start the timer when needed, and run()
+    /// only polls the done flag set by the interrupt when the motor has stopped at the target.
+    /// Only one stepper can be attached to the step timer. The timer must not be used by
+    /// anything else (Servo takes Timer1, or Timer2 when built with SERVO_USE_TIMER2, and
+    /// tone() takes Timer2).
+    /// Caution: change speed and acceleration parameters only while the motor is stopped.
+    /// \return true if the timer was attached to this stepper, false if no step timer was
+    /// compiled in or it is already attached to another stepper.
+    boolean attachTimer();
+
+    /// Stops the step timer and returns this stepper to polled stepping with run().
+    void    detachTimer();
+
+    /// Ends step pulses in hardware instead of busy-waiting for the minimum pulse width.
+    /// Only applies to DRIVER steppers attached to the step timer with attachTimer().
+    /// Each step raises the step pin and arms a one-shot compare B interrupt on the step
+    /// timer, which lowers it again setMinPulseWidth() microseconds later, so no
+    /// interrupt ever waits out the pulse width and large pulse widths for slow drivers
+    /// cost nothing. The width is rounded down to whole timer ticks (at least one tick).
+    /// Steps taken by polling run() without the timer still busy-wait in step1().
+    /// If the step interval is shorter than the pulse width, each pulse is cut short by the next step.
+    /// \param[in] enable true to end pulses with the timer, false (the default) to busy-wait
+    /// \return false if enable is true and this stepper cannot end its pulses in hardware
+    /// (only DRIVER steppers can) or no step timer was compiled in
+    boolean setTimerPulse(bool enable = true);
+
+    /// Called by the step timer compare interrupt. Internal use only.
+    void    timerInterrupt();
+
+    /// Called by the step timer compare B interrupt in pulse mode. Internal use only.
+    void    timerPulseInterrupt();
+
 protected:
+    /// Issues one step, with the step phase number (0 to 7) as for AccelStepper::step()
+    typedef void (*StepFunction)(AccelStepperCore* stepper, long step);
+
+    /// Starts or ends a step pulse, as for AccelStepper::pulseStart() and pulseEnd()
+    typedef void (*PulseFunction)(AccelStepperCore* stepper);
+
+    /// Constructor. Current Position is set to 0, target position is set to 0.
+    /// MaxSpeed and Acceleration default to 1.0.
+    /// \param[in] step Called to issue each step
+    /// \param[in] pulseStart Called to start each step pulse when setTimerPulse() is enabled,
+    /// or 0 if the stepper cannot end its pulses in hardware
+    /// \param[in] pulseEnd Called to end each step pulse started by pulseStart
+    AccelStepperCore(StepFunction step, PulseFunction pulseStart, PulseFunction pulseEnd);
 
     /// \brief Direction indicator
     /// Symbolic names for the direction the motor is turning
@@ -544,7 +524,10 @@ protected:
     } Direction;
 
     /// Forces the library to compute a new instantaneous speed and set that as
-    /// the current speed. It is called by
+    /// the current speed. When built with ACCELSTEPPER_FIXED_POINT the per step
+    /// ramp maths is done in fixed point integers instead of floats, which is much
+    /// cheaper on processors without an FPU. The fixed point ramp holds for
+    /// accelerations above about 0.06 steps per second per second. It is called by
     /// the library:
     /// \li  after each step
     /// \li  after change to maxSpeed through setMaxSpeed()
@@ -553,9 +536,303 @@ protected:
     /// move() or moveTo()
     void           computeNewSpeed();
 
+    /// computeNewSpeed() for S-curve profiles, used when a jerk limit is set
+    void           computeNewSpeedSCurve();
+
+    /// Distance in steps needed to stop from speed v and acceleration a
+    /// (both in the direction of travel) with the current jerk limit
+    float          sCurveStepsToStop(float v, float a);
+
+    /// Checks whether a step is due at the current speed and, if so, advances the current
+    /// position and the step time for it. The caller must then issue the step.
+    /// runSpeed() is stepDue() followed by the step function.
+    /// \return true if a step is due
+    boolean        stepDue();
+
+    /// Current direction motor is spinning in
+    /// Protected because some peoples subclasses need it to be so
+    boolean _direction; // 1 == CW
+    
+private:
+    /// AccelStepper and AccelStepperT issue the steps and drive the enable pin
+    friend class AccelStepper;
+    template <uint8_t, uint8_t, uint8_t, bool, bool> friend class AccelStepperT;
+
+    /// MultiStepper drives the steps of all its steppers from one leader in coordinated mode
+    friend class MultiStepper;
+
+    /// The step functions given to the constructor
+    StepFunction   _stepFunction;
+    PulseFunction  _pulseStartFunction;
+    PulseFunction  _pulseEndFunction;
+
+    /// The current absolution position in steps.
+    long           _currentPos;    // Steps
+
+    /// The target position in steps. The AccelStepper library will move the
+    /// motor from the _currentPos to the _targetPos, taking into account the
+    /// max speed, acceleration and deceleration
+    long           _targetPos;     // Steps
+
+    /// The current motos speed in steps per second
+    /// Positive is clockwise
+    /// With ACCELSTEPPER_FIXED_POINT this is not a speed while run() is ramping:
+    /// computeNewSpeed() sets it to just +1.0 or -1.0 for the direction (0.0 when stopped,
+    /// and the given speed after setSpeed()). Code reading it directly, such as step0(),
+    /// must only use its sign; speed() works out the magnitude from the step interval.
+    float          _speed;         // Steps per second
+
+    /// The maximum permitted speed in steps per second. Must be > 0.
+    float          _maxSpeed;
+
+    /// The acceleration to use to accelerate or decelerate the motor in steps
+    /// per second per second. Must be > 0
+    float          _acceleration;
+    float          _sqrt_twoa; // Precomputed sqrt(2*_acceleration)
+
+    /// The current interval between steps in microseconds.
+    /// 0 means the motor is currently stopped with _speed == 0
+    unsigned long  _stepInterval;
+
+    /// The last step time in microseconds
+    unsigned long  _lastStepTime;
+
+    /// Maximum lag in step intervals that runSpeed() catches up on, 0 to time
+    /// each step from the previous one actually taken
+    uint8_t        _maxCatchUp;
+
+    /// Number of steps issued after they were due
+    unsigned long  _lateSteps;
+
+    /// True until the first step after the stepper was stopped, which has no due time
+    bool           _stepFromRest;
+
+    /// The minimum allowed pulse width in microseconds
+    unsigned int   _minPulseWidth;
+
+    /// Is the direction pin inverted?
+    ///bool           _dirInverted; /// Moved to _pinInverted[1]
+
+    /// Is the step pin inverted?
+    ///bool           _stepInverted; /// Moved to _pinInverted[0]
+
+    /// Is the enable pin inverted?
+    bool           _enableInverted;
+
+    /// Enable pin for stepper driver, or 0xFF if unused.
+    uint8_t        _enablePin;
+
+    /// The step counter for speed calculations
+    long _n;
+
+    /// Initial step size in microseconds
+    float _c0;
+
+    /// Last step size in microseconds
+    float _cn;
+
+    /// Min step size in microseconds based on maxSpeed
+    float _cmin; // at max speed
+
+    /// _c0, _cn and _cmin in fixed point microseconds with _fixedShift fraction bits,
+    /// used by computeNewSpeed() when built with ACCELSTEPPER_FIXED_POINT
+    unsigned long _c0Fixed;
+    unsigned long _cnFixed;
+    unsigned long _cminFixed;
+    uint8_t       _fixedShift;
+
+    /// Steps needed to stop from maxSpeed, per Equation 16
+    long _stepsToStopMax;
+
+    /// Jerk limit in steps per second per second per second, 0.0 for trapezoidal profiles
+    float _jerk;
+
+    /// Current acceleration in the direction of travel, for S-curve profiles
+    float _sCurveAccel;
+
+    /// Speed after the first step from rest with the current jerk limit
+    float _sCurveMinSpeed;
+
+    /// Position when the S-curve speed was last updated. The update integrates over one
+    /// step, so calls with no step taken since (from moveTo(), stop() etc) leave it alone
+    long _sCurvePos;
+
+    /// Precomputed ramp step intervals in program memory, or 0 if not used
+    const uint16_t* _rampTable;
+    uint16_t        _rampTableLength;
+
+    /// Looks up the ramp table interval in microseconds for the next step, or 0 if the
+    /// table does not cover it
+    unsigned long   rampTableInterval();
+
+    /// True while this stepper is attached to the hardware step timer
+    bool           _timerAttached;
+
+    /// Set by the step timer interrupt when the motor has stopped at the target
+    volatile bool  _timerDone;
+
+    /// Step timer ticks still to count in the current step interval
+    unsigned long  _timerTicksLeft;
+
+    /// Loads the step timer compare register with the next chunk of _timerTicksLeft
+    void           loadTimer();
+
+    /// True if step pulses are ended by the step timer, see setTimerPulse()
+    bool           _timerPulse;
+
+    /// True while a step pulse started by the step timer is still high
+    volatile bool  _pulseHigh;
+
+    /// Step timer ticks still to count before the current step pulse ends
+    unsigned long  _pulseTicksLeft;
+
+    /// Ends the current step pulse and clears _pulseHigh
+    void           endPulse();
+
+    /// Arms the step timer compare B to end the current pulse, if it ends within the current chunk
+    void           loadPulseTimer();
+};
+
+/////////////////////////////////////////////////////////////////////
+/// \class AccelStepper AccelStepper.h <AccelStepper.h>
+/// \brief Support for stepper motors with acceleration etc.
+///
+/// This defines a single 2 or 4 pin stepper motor, or stepper moter with fdriver chip, with optional
+/// acceleration, deceleration, absolute positioning commands etc. Multiple
+/// simultaneous steppers are supported, all moving 
+/// at different speeds and accelerations. 
+///
+/// \par Operation
+/// This module operates by computing a step time in microseconds. The step
+/// time is recomputed after each step and after speed and acceleration
+/// parameters are changed by the caller. The time of each step is recorded in
+/// microseconds. The run() function steps the motor once if a new step is due.
+/// The run() function must be called frequently until the motor is in the
+/// desired position, after which time run() will do nothing.
+///
+/// \par Positioning
+/// Positions are specified by a signed long integer. At
+/// construction time, the current position of the motor is consider to be 0. Positive
+/// positions are clockwise from the initial position; negative positions are
+/// anticlockwise. The current position can be altered for instance after
+/// initialization positioning.
+///
+/// \par Caveats
+/// This is an open loop controller: If the motor stalls or is oversped,
+/// AccelStepper will not have a correct 
+/// idea of where the motor really is (since there is no feedback of the motor's
+/// real position. We only know where we _think_ it is, relative to the
+/// initial starting point).
+///
+/// \par Performance
+/// The fastest motor speed that can be reliably supported is about 4000 steps per
+/// second at a clock frequency of 16 MHz on Arduino such as Uno etc. 
+/// Faster processors can support faster stepping speeds. 
+/// However, any speed less than that
+/// down to very slow speeds (much less than one per second) are also supported,
+/// provided the run() function is called frequently enough to step the motor
+/// whenever required for the speed set.
+/// Calling setAcceleration() is expensive,
+/// since it requires a square root to be calculated.
+///
+/// Gregor Christandl reports that with an Arduino Due and a simple test program, 
+/// he measured 43163 steps per second using runSpeed(), 
+/// and 16214 steps per second using run();
+class AccelStepper : public AccelStepperCore
+{
+public:
+    /// \brief Symbolic names for number of pins.
+    /// Use this in the pins argument the AccelStepper constructor to 
+    /// provide a symbolic name for the number of pins
+    /// to use.
+    typedef enum
+    {
+	FUNCTION  = 0, ///< Use the functional interface, implementing your own driver functions (internal use only)
+	DRIVER    = 1, ///< Stepper Driver, 2 driver pins required
+	FULL2WIRE = 2, ///< 2 wire stepper, 2 motor pins required
+	FULL3WIRE = 3, ///< 3 wire stepper, such as HDD spindle, 3 motor pins required
+        FULL4WIRE = 4, ///< 4 wire full stepper, 4 motor pins required
+	HALF3WIRE = 6, ///< 3 wire half stepper, such as HDD spindle, 3 motor pins required
+	HALF4WIRE = 8  ///< 4 wire half stepper, 4 motor pins required
+    } MotorInterfaceType;
+
+    /// Constructor. You can have multiple simultaneous steppers, all moving
+    /// at different speeds and accelerations, provided you call their run()
+    /// functions at frequent enough intervals. Current Position is set to 0, target
+    /// position is set to 0. MaxSpeed and Acceleration default to 1.0.
+    /// The motor pins will be initialised to OUTPUT mode during the
+    /// constructor by a call to enableOutputs().
+    /// \param[in] interface Number of pins to interface to. Integer values are
+    /// supported, but it is preferred to use the \ref MotorInterfaceType symbolic names. 
+    /// AccelStepper::DRIVER (1) means a stepper driver (with Step and Direction pins).
+    /// If an enable line is also needed, call setEnablePin() after construction.
+    /// You may also invert the pins using setPinsInverted().
+    /// Caution: DRIVER implements a blocking delay of minPulseWidth microseconds (default 1us) for each step.
+    /// You can change this with setMinPulseWidth().
+    /// AccelStepper::FULL2WIRE (2) means a 2 wire stepper (2 pins required). 
+    /// AccelStepper::FULL3WIRE (3) means a 3 wire stepper, such as HDD spindle (3 pins required). 
+    /// AccelStepper::FULL4WIRE (4) means a 4 wire stepper (4 pins required). 
+    /// AccelStepper::HALF3WIRE (6) means a 3 wire half stepper, such as HDD spindle (3 pins required)
+    /// AccelStepper::HALF4WIRE (8) means a 4 wire half stepper (4 pins required)
+    /// Defaults to AccelStepper::FULL4WIRE (4) pins.
+    /// \param[in] pin1 Arduino digital pin number for motor pin 1. Defaults
+    /// to pin 2. For a AccelStepper::DRIVER (interface==1), 
+    /// this is the Step input to the driver. Low to high transition means to step)
+    /// \param[in] pin2 Arduino digital pin number for motor pin 2. Defaults
+    /// to pin 3. For a AccelStepper::DRIVER (interface==1), 
+    /// this is the Direction input the driver. High means forward.
+    /// \param[in] pin3 Arduino digital pin number for motor pin 3. Defaults
+    /// to pin 4.
+    /// \param[in] pin4 Arduino digital pin number for motor pin 4. Defaults
+    /// to pin 5.
+    /// \param[in] enable If this is true (the default), enableOutputs() will be called to enable
+    /// the output pins at construction time.
+    AccelStepper(uint8_t interface = AccelStepper::FULL4WIRE, uint8_t pin1 = 2, uint8_t pin2 = 3, uint8_t pin3 = 4, uint8_t pin4 = 5, bool enable = true);
+
+    /// Alternate Constructor which will call your own functions for forward and backward steps. 
+    /// You can have multiple simultaneous steppers, all moving
+    /// at different speeds and accelerations, provided you call their run()
+    /// functions at frequent enough intervals. Current Position is set to 0, target
+    /// position is set to 0. MaxSpeed and Acceleration default to 1.0.
+    /// Any motor initialization should happen before hand, no pins are used or initialized.
+    /// \param[in] forward void-returning procedure that will make a forward step
+    /// \param[in] backward void-returning procedure that will make a backward step
+    AccelStepper(void (*forward)(), void (*backward)());
+    
+    /// Disable motor pin outputs by setting them all LOW
+    /// Depending on the design of your electronics this may turn off
+    /// the power to the motor coils, saving power.
+    /// This is useful to support Arduino low power modes: disable the outputs
+    /// during sleep and then reenable with enableOutputs() before stepping
+    /// again.
+    /// If the enable Pin is defined, sets it to OUTPUT mode and clears the pin to disabled.
+    virtual void    disableOutputs();
+
+    /// Enable motor pin outputs by setting the motor pins to OUTPUT
+    /// mode. Called automatically by the constructor.
+    /// If the enable Pin is defined, sets it to OUTPUT mode and sets the pin to enabled.
+    virtual void    enableOutputs();
+
+    /// Sets the inversion for stepper driver pins
+    /// \param[in] directionInvert True for inverted direction pin, false for non-inverted
+    /// \param[in] stepInvert      True for inverted step pin, false for non-inverted
+    /// \param[in] enableInvert    True for inverted enable pin, false (default) for non-inverted
+    void    setPinsInverted(bool directionInvert = false, bool stepInvert = false, bool enableInvert = false);
+
+    /// Sets the inversion for 2, 3 and 4 wire stepper pins
+    /// \param[in] pin1Invert True for inverted pin1, false for non-inverted
+    /// \param[in] pin2Invert True for inverted pin2, false for non-inverted
+    /// \param[in] pin3Invert True for inverted pin3, false for non-inverted
+    /// \param[in] pin4Invert True for inverted pin4, false for non-inverted
+    /// \param[in] enableInvert    True for inverted enable pin, false (default) for non-inverted
+    void    setPinsInverted(bool pin1Invert, bool pin2Invert, bool pin3Invert, bool pin4Invert, bool enableInvert);
+
+protected:
     /// Low level function to set the motor output pins
     /// bit 0 of the mask corresponds to _pin[0]
     /// bit 1 of the mask corresponds to _pin[1]
+    /// On AVR the pins are written straight to their port registers. Unlike digitalWrite(),
+    /// this does not turn off PWM on the pins, so dont use analogWrite() on motor pins.
     /// You can override this to impment, for example serial chip output insted of using the
     /// output pins directly
     virtual void   setOutputPins(uint8_t mask);
@@ -567,6 +844,14 @@ protected:
     /// \param[in] step The current step phase number (0 to 7)
     virtual void   step(long step);
 
+    /// Starts a step pulse for setTimerPulse(): sets the direction pin and raises the
+    /// step pin of a DRIVER stepper, like the first half of step1().
+    /// Subclasses that override step1() for a DRIVER should override this and pulseEnd() too.
+    virtual void   pulseStart();
+
+    /// Ends a step pulse started by pulseStart() by lowering the step pin. Called from interrupt context.
+    virtual void   pulseEnd();
+
     /// Called to execute a step using stepper functions (pins = 0) Only called when a new step is
     /// required. Calls _forward() or _backward() to perform the step
     /// \param[in] step The current step phase number (0 to 7)
@@ -614,11 +899,15 @@ protected:
     /// \param[in] step The current step phase number (0 to 7)
     virtual void   step8(long step);
 
-    /// Current direction motor is spinning in
-    /// Protected because some peoples subclasses need it to be so
-    boolean _direction; // 1 == CW
-    
 private:
+    /// MultiStepper issues the steps of all its steppers itself in coordinated mode
+    friend class MultiStepper;
+
+    /// The step functions handed to AccelStepperCore, which call step(), pulseStart() and pulseEnd()
+    static void    coreStep(AccelStepperCore* stepper, long step);
+    static void    corePulseStart(AccelStepperCore* stepper);
+    static void    corePulseEnd(AccelStepperCore* stepper);
+
     /// Number of pins on the stepper motor. Permits 2 or 4. 2 pins is a
     /// bipolar, and 4 pins is a unipolar.
     uint8_t        _interface;          // 0, 1, 2, 4, 8, See MotorInterfaceType
@@ -630,66 +919,18 @@ private:
     /// Whether the _pins is inverted or not
     uint8_t        _pinInverted[4];
 
-    /// The current absolution position in steps.
-    long           _currentPos;    // Steps
-
-    /// The target position in steps. The AccelStepper library will move the
-    /// motor from the _currentPos to the _targetPos, taking into account the
-    /// max speed, acceleration and deceleration
-    long           _targetPos;     // Steps
-
-    /// The current motos speed in steps per second
-    /// Positive is clockwise
-    float          _speed;         // Steps per second
-
-    /// The maximum permitted speed in steps per second. Must be > 0.
-    float          _maxSpeed;
-
-    /// The acceleration to use to accelerate or decelerate the motor in steps
-    /// per second per second. Must be > 0
-    float          _acceleration;
-    float          _sqrt_twoa; // Precomputed sqrt(2*_acceleration)
-
-    /// The current interval between steps in microseconds.
-    /// 0 means the motor is currently stopped with _speed == 0
-    unsigned long  _stepInterval;
-
-    /// The last step time in microseconds
-    unsigned long  _lastStepTime;
-
-    /// The minimum allowed pulse width in microseconds
-    unsigned int   _minPulseWidth;
-
-    /// Is the direction pin inverted?
-    ///bool           _dirInverted; /// Moved to _pinInverted[1]
-
-    /// Is the step pin inverted?
-    ///bool           _stepInverted; /// Moved to _pinInverted[0]
-
-    /// Is the enable pin inverted?
-    bool           _enableInverted;
-
-    /// Enable pin for stepper driver, or 0xFF if unused.
-    uint8_t        _enablePin;
+#if defined(ARDUINO_ARCH_AVR)
+    /// Output port register and bit mask for each of _pin, resolved once at construction
+    /// so setOutputPins() can write the ports directly instead of calling digitalWrite()
+    volatile uint8_t* _pinPort[4];
+    uint8_t        _pinMask[4];
+#endif
 
     /// The pointer to a forward-step procedure
     void (*_forward)();
 
     /// The pointer to a backward-step procedure
     void (*_backward)();
-
-    /// The step counter for speed calculations
-    long _n;
-
-    /// Initial step size in microseconds
-    float _c0;
-
-    /// Last step size in microseconds
-    float _cn;
-
-    /// Min step size in microseconds based on maxSpeed
-    float _cmin; // at max speed
-
 };
 
 /// @example Random.pde
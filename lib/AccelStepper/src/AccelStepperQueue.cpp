@@ -0,0 +1,156 @@
+// AccelStepperQueue.cpp
+
+#include "AccelStepperQueue.h"
+#include "AccelStepper.h"
+
+AccelStepperQueue::AccelStepperQueue(AccelStepperCore& stepper)
+    : _stepper(&stepper),
+      _head(0),
+      _count(0),
+      _lastTarget(0),
+      _moveFrom(0),
+      _moveTo(0),
+      _type(MOVE),
+      _running(false),
+      _startTime(0),
+      _duration(0)
+{
+}
+
+boolean AccelStepperQueue::move(long relative)
+{
+    if (_count == 0)
+	_lastTarget = _stepper->targetPosition();
+    return push(MOVE, _lastTarget + relative, 0);
+}
+
+boolean AccelStepperQueue::moveTo(long absolute)
+{
+    return push(MOVE, absolute, 0);
+}
+
+boolean AccelStepperQueue::dwell(unsigned long milliseconds)
+{
+    return push(DWELL, 0, milliseconds);
+}
+
+boolean AccelStepperQueue::hold()
+{
+    return push(HOLD, 0, 0);
+}
+
+boolean AccelStepperQueue::push(uint8_t type, long target, unsigned long duration)
+{
+    if (_count >= ACCELSTEPPERQUEUE_LENGTH)
+	return false; // No room for more
+
+    Segment* segment = &_segments[(_head + _count) % ACCELSTEPPERQUEUE_LENGTH];
+    segment->type = type;
+    segment->target = target;
+    segment->duration = duration;
+    _count++;
+    if (type == MOVE)
+	_lastTarget = target;
+    return true;
+}
+
+void AccelStepperQueue::release()
+{
+    if (isHeld())
+	_running = false;
+}
+
+boolean AccelStepperQueue::isHeld()
+{
+    return _running && _type == HOLD;
+}
+
+boolean AccelStepperQueue::run()
+{
+    if (_running)
+    {
+	switch (_type)
+	{
+	    case MOVE:
+		_running = _stepper->run();
+		if (_running && carriesOn())
+		    start(); // Hand over the next target now so the stepper does not stop in between
+		break;
+
+	    case DWELL:
+		_running = (millis() - _startTime) < _duration;
+		break;
+
+	    default: // HOLD, until release()
+		break;
+	}
+	if (_running)
+	    return true;
+    }
+    if (_count)
+    {
+	start();
+	return true;
+    }
+    return false;
+}
+
+boolean AccelStepperQueue::runToEnd()
+{
+    while (run())
+    {
+	if (isHeld())
+	    return false;
+    }
+    return true;
+}
+
+void AccelStepperQueue::clear()
+{
+    _count = 0;
+}
+
+uint8_t AccelStepperQueue::available()
+{
+    return ACCELSTEPPERQUEUE_LENGTH - _count;
+}
+
+uint8_t AccelStepperQueue::queued()
+{
+    return _count;
+}
+
+// On one axis the only junction that needs the speed to come down is a reversal, and the
+// stepper already slows down in time for its final target, so a move in the same direction
+// can be joined on at full speed
+boolean AccelStepperQueue::carriesOn()
+{
+    if (!_count)
+	return false;
+    Segment* segment = &_segments[_head];
+    if (segment->type != MOVE)
+	return false;
+    if (_moveTo > _moveFrom)
+	return segment->target > _moveTo;
+    if (_moveTo < _moveFrom)
+	return segment->target < _moveTo;
+    return false;
+}
+
+void AccelStepperQueue::start()
+{
+    Segment* segment = &_segments[_head];
+    _head = (_head + 1) % ACCELSTEPPERQUEUE_LENGTH;
+    _count--;
+
+    _type = segment->type;
+    _duration = segment->duration;
+    _startTime = millis();
+    _running = true;
+    if (_type == MOVE)
+    {
+	_moveFrom = _stepper->targetPosition();
+	_moveTo = segment->target;
+	_stepper->moveTo(segment->target);
+    }
+}
@@ -0,0 +1,150 @@
+// AccelStepperQueue.h
+
+#ifndef AccelStepperQueue_h
+#define AccelStepperQueue_h
+
+#include <stdlib.h>
+#if ARDUINO >= 100
+#include <Arduino.h>
+#else
+#include <WProgram.h>
+#include <wiring.h>
+#endif
+
+#define ACCELSTEPPERQUEUE_LENGTH 8
+
+class AccelStepperCore;
+
+/////////////////////////////////////////////////////////////////////
+/// \class AccelStepperQueue AccelStepperQueue.h <AccelStepperQueue.h>
+/// \brief Queue of moves, dwells and holds for one AccelStepper
+///
+/// AccelStepperQueue holds up to ACCELSTEPPERQUEUE_LENGTH segments that are run one after
+/// the other on an AccelStepper, so a whole sequence such as feed, wait for the cutter,
+/// pause, feed again can be handed over at once instead of issuing each move only when
+/// the previous one has finished:
+/// \code
+/// AccelStepperQueue queue(stepper);
+/// queue.move(400);
+/// queue.hold();      // Wait here for release()
+/// queue.dwell(500);  // Then pause for 500 ms
+/// queue.move(400);
+/// while (queue.run())
+/// {
+///     if (queue.isHeld())
+///     {
+///         cut();
+///         queue.release();
+///     }
+/// }
+/// \endcode
+/// Targets are made absolute as they are queued, so starting the next segment is just a
+/// moveTo() on the stepper, and AccelStepper works out the ramp step by step as it runs.
+/// Consecutive moves in the same direction carry their speed across the boundary: the next
+/// target is handed to the stepper while the current move is still running, so it only
+/// slows down for the last of them. Moves that reverse, and dwells and holds, start from rest.
+/// Moves use the stepper's acceleration and max speed. Call run() as often as you would call
+/// AccelStepper::run(); it works both with polled stepping and with AccelStepper::attachTimer().
+/// Caution: dont command the stepper directly while the queue is running.
+class AccelStepperQueue
+{
+public:
+    /// Constructor
+    /// \param[in] stepper The stepper to run the segments on, an AccelStepper or AccelStepperT
+    AccelStepperQueue(AccelStepperCore& stepper);
+
+    /// Queues a move relative to the target of the previous move in the queue
+    /// (or the stepper's target position if there is none)
+    /// \param[in] relative The distance to move in steps. Positive is clockwise.
+    /// \return true if successful. false if the queue is full
+    boolean move(long relative);
+
+    /// Queues a move to an absolute position
+    /// \param[in] absolute The target position in steps
+    /// \return true if successful. false if the queue is full
+    boolean moveTo(long absolute);
+
+    /// Queues a pause with the motor stopped
+    /// \param[in] milliseconds How long to wait
+    /// \return true if successful. false if the queue is full
+    boolean dwell(unsigned long milliseconds);
+
+    /// Queues a hold: when the queue gets to it, it waits with the motor stopped
+    /// until release() is called
+    /// \return true if successful. false if the queue is full
+    boolean hold();
+
+    /// Ends the hold the queue is waiting at, if any
+    void    release();
+
+    /// Checks whether the queue is waiting at a hold for release()
+    /// \return true if held
+    boolean isHeld();
+
+    /// Runs the current segment and starts the next one when it has finished, or straight
+    /// away if it is a move that carries on in the same direction.
+    /// \return true while a segment is running or queued
+    boolean run();
+
+    /// Runs all queued segments, blocking until they are done. A hold ends the wait
+    /// and returns false, since nothing else can release it.
+    /// \return true if all segments are done, false if stopped at a hold
+    boolean runToEnd();
+
+    /// Drops all queued segments that have not started yet. The current segment runs to completion.
+    void    clear();
+
+    /// \return The number of segments that can still be queued
+    uint8_t available();
+
+    /// \return The number of segments queued, not counting the one running
+    uint8_t queued();
+
+private:
+    typedef enum
+    {
+	MOVE,  ///< Move to target
+	DWELL, ///< Wait for duration
+	HOLD   ///< Wait for release()
+    } SegmentType;
+
+    typedef struct
+    {
+	uint8_t       type;      ///< SegmentType
+	long          target;    ///< MOVE: absolute target position
+	unsigned long duration;  ///< DWELL: the dwell in milliseconds
+    } Segment;
+
+    /// Adds a segment at the tail of the queue
+    boolean       push(uint8_t type, long target, unsigned long duration);
+
+    /// Checks whether the segment at the head of the queue is a move that carries on
+    /// in the direction of the move running now
+    boolean       carriesOn();
+
+    /// Starts the segment at the head of the queue
+    void          start();
+
+    /// The stepper the segments run on
+    AccelStepperCore* _stepper;
+
+    /// Ring buffer of queued segments, _count of them starting at _head
+    Segment       _segments[ACCELSTEPPERQUEUE_LENGTH];
+    uint8_t       _head;
+    uint8_t       _count;
+
+    /// Target of the last move queued, for move()
+    long          _lastTarget;
+
+    /// Where the move running now started from and is going to
+    long          _moveFrom;
+    long          _moveTo;
+
+    /// The segment running now: its type, true while running, and when it started
+    uint8_t       _type;
+    boolean       _running;
+    unsigned long _startTime;
+    unsigned long _duration;
+};
+
+#endif
@@ -0,0 +1,94 @@
+// AccelStepperRamp.h
+//
+// Compile time acceleration ramp tables for AccelStepper::setRampTable()
+
+#ifndef AccelStepperRamp_h
+#define AccelStepperRamp_h
+
+#include "AccelStepper.h"
+
+template <unsigned... I> struct AccelStepperRampIndices {};
+
+template <class A, class B> struct AccelStepperRampJoin;
+
+template <unsigned... I, unsigned... J>
+struct AccelStepperRampJoin<AccelStepperRampIndices<I...>, AccelStepperRampIndices<J...> >
+{
+    typedef AccelStepperRampIndices<I..., (sizeof...(I) + J)...> type;
+};
+
+// Builds 0 ... N - 1 by halving, so the template depth stays at log2(N)
+template <unsigned N> struct AccelStepperRampMakeIndices
+{
+    typedef typename AccelStepperRampJoin<typename AccelStepperRampMakeIndices<N / 2>::type,
+					  typename AccelStepperRampMakeIndices<N - N / 2>::type>::type type;
+};
+
+template <> struct AccelStepperRampMakeIndices<0> { typedef AccelStepperRampIndices<> type; };
+template <> struct AccelStepperRampMakeIndices<1> { typedef AccelStepperRampIndices<0> type; };
+
+// Newton's method, good to float precision well within 32 iterations for the step numbers we need
+constexpr float accelStepperRampSqrt(float x, float guess, uint8_t iterations)
+{
+    return iterations == 0 ? guess : accelStepperRampSqrt(x, (guess + x / guess) / 2, iterations - 1);
+}
+
+constexpr float accelStepperRampSqrt(float x)
+{
+    return x <= 0 ? 0 : accelStepperRampSqrt(x, x > 1 ? x / 2 : 1, 32);
+}
+
+// Interval in microseconds of step n of a ramp from rest.
+// sqrt(n + 1) - sqrt(n) is written as 1 / (sqrt(n) + sqrt(n + 1)) to keep the precision
+constexpr float accelStepperRampInterval(unsigned long acceleration, unsigned long n)
+{
+    return 1000000.0 * accelStepperRampSqrt(2.0 / acceleration)
+	/ (accelStepperRampSqrt(n) + accelStepperRampSqrt(n + 1));
+}
+
+/////////////////////////////////////////////////////////////////////
+/// \class AccelStepperRamp AccelStepperRamp.h <AccelStepperRamp.h>
+/// \brief Acceleration ramp step interval table generated at compile time
+///
+/// When the acceleration and maximum speed of a stepper are fixed when the firmware is built,
+/// the whole sequence of step intervals from c0 down to cmin is known in advance.
+/// AccelStepperRamp computes that sequence with constexpr functions and stores it in
+/// program memory, ready to be handed to AccelStepper::setRampTable():
+/// \code
+/// typedef AccelStepperRamp<100, 500> FeedRamp; // 100 steps/s/s up to 500 steps/s
+/// stepper.setAcceleration(100);
+/// stepper.setMaxSpeed(500);
+/// stepper.setRampTable(FeedRamp::table, FeedRamp::length);
+/// \endcode
+/// Entry n - 1 holds the interval of step n of a ramp from rest. It is the exact interval
+/// 1000000 * sqrt(2 / Acceleration) * (sqrt(n + 1) - sqrt(n)) microseconds that Equation 13
+/// approximates, so the table has none of the error of the approximation for small n.
+/// There is one entry per step up to max speed, so the table takes
+/// MaxSpeed * MaxSpeed / Acceleration bytes of flash.
+/// The intervals are stored in 16 bits, which requires an Acceleration of at least
+/// 80 steps per second per second.
+template <unsigned long Acceleration, unsigned long MaxSpeed,
+	  class Indices = typename AccelStepperRampMakeIndices<MaxSpeed * MaxSpeed / (2 * Acceleration)>::type>
+struct AccelStepperRamp;
+
+template <unsigned long Acceleration, unsigned long MaxSpeed, unsigned... I>
+struct AccelStepperRamp<Acceleration, MaxSpeed, AccelStepperRampIndices<I...> >
+{
+    static_assert(Acceleration > 0 && MaxSpeed > 0, "Acceleration and MaxSpeed must be > 0");
+    static_assert(accelStepperRampInterval(Acceleration, 1) < 65535.0,
+		  "Acceleration too low for 16 bit step intervals");
+
+    /// Number of entries in table
+    static const uint16_t length = sizeof...(I);
+
+    /// Step intervals in microseconds for steps 1 ... length, in program memory
+    static const uint16_t table[sizeof...(I)];
+};
+
+template <unsigned long Acceleration, unsigned long MaxSpeed, unsigned... I>
+const uint16_t AccelStepperRamp<Acceleration, MaxSpeed, AccelStepperRampIndices<I...> >::table[sizeof...(I)] PROGMEM =
+{
+    (uint16_t)(accelStepperRampInterval(Acceleration, I + 1) + 0.5)...
+};
+
+#endif
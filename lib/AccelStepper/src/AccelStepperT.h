@@ -0,0 +1,237 @@
+// AccelStepperT.h
+//
+// AccelStepper with the motor interface and pins fixed at compile time
+
+#ifndef AccelStepperT_h
+#define AccelStepperT_h
+
+#include "AccelStepper.h"
+
+/////////////////////////////////////////////////////////////////////
+/// \class AccelStepperPin AccelStepperT.h <AccelStepperT.h>
+/// \brief A single output pin known at compile time
+///
+/// On ATmega168/328 boards the pin number is mapped to its port and bit at compile time,
+/// so write() compiles to a single sbi or cbi instruction. Elsewhere it falls back
+/// to digitalWrite().
+template <uint8_t Pin, bool Inverted>
+struct AccelStepperPin
+{
+    static inline void output()
+    {
+	pinMode(Pin, OUTPUT);
+    }
+
+    static inline void write(bool value)
+    {
+#if defined(__AVR_ATmega168__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega328P__)
+	// Standard Arduino pin mapping: 0-7 on PORTD, 8-13 on PORTB, 14-19 (A0-A5) on PORTC
+	static_assert(Pin < 20, "Pin must be 0-19 on ATmega168/328");
+	volatile uint8_t& port = (Pin < 8) ? PORTD : (Pin < 14) ? PORTB : PORTC;
+	const uint8_t bit = _BV((Pin < 8) ? Pin : (Pin < 14) ? Pin - 8 : Pin - 14);
+	if (value ^ Inverted)
+	    port |= bit;
+	else
+	    port &= ~bit;
+#else
+	digitalWrite(Pin, value ^ Inverted);
+#endif
+    }
+};
+
+/////////////////////////////////////////////////////////////////////
+/// \class AccelStepperInterface AccelStepperT.h <AccelStepperT.h>
+/// \brief Compile time step functions for one AccelStepper::MotorInterfaceType
+///
+/// Each specialisation provides static enable(), disable() and step() functions
+/// equivalent to AccelStepper::enableOutputs(), disableOutputs() and step1() ... step8().
+/// DRIVER and FULL2WIRE are provided.
+template <uint8_t Interface, uint8_t Pin1, uint8_t Pin2, bool Pin1Inverted, bool Pin2Inverted>
+struct AccelStepperInterface;
+
+template <uint8_t Pin1, uint8_t Pin2, bool Pin1Inverted, bool Pin2Inverted>
+struct AccelStepperInterface<AccelStepper::DRIVER, Pin1, Pin2, Pin1Inverted, Pin2Inverted>
+{
+    typedef AccelStepperPin<Pin1, Pin1Inverted> Step;
+    typedef AccelStepperPin<Pin2, Pin2Inverted> Direction;
+
+    static inline void enable()
+    {
+	Step::output();
+	Direction::output();
+    }
+
+    static inline void disable()
+    {
+	Step::write(false);
+	Direction::write(false);
+    }
+
+    // Same sequence as AccelStepper::step1()
+    static inline void step(long step, bool direction, unsigned int minPulseWidth)
+    {
+	(void)(step); // Unused
+	Direction::write(direction); // Set direction first else get rogue pulses
+	Step::write(true);
+	// Caution 200ns setup time
+	// Delay the minimum allowed pulse width
+	delayMicroseconds(minPulseWidth);
+	Step::write(false);
+    }
+
+    // step() split in two for AccelStepper::setTimerPulse()
+    static inline void pulseStart(bool direction)
+    {
+	Direction::write(direction);
+	Step::write(true);
+    }
+
+    static inline void pulseEnd()
+    {
+	Step::write(false);
+    }
+};
+
+template <uint8_t Pin1, uint8_t Pin2, bool Pin1Inverted, bool Pin2Inverted>
+struct AccelStepperInterface<AccelStepper::FULL2WIRE, Pin1, Pin2, Pin1Inverted, Pin2Inverted>
+{
+    typedef AccelStepperPin<Pin1, Pin1Inverted> Coil1;
+    typedef AccelStepperPin<Pin2, Pin2Inverted> Coil2;
+
+    static inline void enable()
+    {
+	Coil1::output();
+	Coil2::output();
+    }
+
+    static inline void disable()
+    {
+	Coil1::write(false);
+	Coil2::write(false);
+    }
+
+    // Same sequence as AccelStepper::step2()
+    static inline void step(long step, bool direction, unsigned int minPulseWidth)
+    {
+	(void)(direction); // Unused
+	(void)(minPulseWidth); // Unused
+	Coil1::write((step & 0x3) == 1 || (step & 0x3) == 2);
+	Coil2::write((step & 0x3) == 0 || (step & 0x3) == 1);
+    }
+
+    // No step pulse: setTimerPulse() is only for DRIVER
+    static inline void pulseStart(bool direction)
+    {
+	(void)(direction); // Unused
+    }
+
+    static inline void pulseEnd()
+    {
+    }
+};
+
+/////////////////////////////////////////////////////////////////////
+/// \class AccelStepperT AccelStepperT.h <AccelStepperT.h>
+/// \brief AccelStepper with the interface, pins and pin inversion fixed at compile time
+///
+/// AccelStepperT has the same API and motion behaviour as AccelStepper, but the motor
+/// interface, pins and pin inversion are template parameters instead of constructor
+/// arguments, eg for a stepper driver with Step on pin 2 and Direction on pin 3:
+/// \code
+/// AccelStepperT<AccelStepper::DRIVER, 2, 3> stepper;
+/// \endcode
+/// It shares the motion code with AccelStepper through AccelStepperCore, but is not an
+/// AccelStepper: the step pulse goes straight to the AccelStepperInterface for that
+/// interface instead of through the virtual step() and the _interface switch, so on
+/// ATmega168/328 a DRIVER step is a few sbi/cbi instructions, and none of the AccelStepper
+/// step functions or its vtable are linked in. run() and runSpeed() issue the step inline.
+/// The step timer interrupt and AccelStepperQueue reach it through a plain function pointer.
+/// setPinsInverted() only sets the enable pin inversion: use the Pin1Inverted and
+/// Pin2Inverted parameters for the others. MultiStepper only takes an AccelStepper.
+/// The runtime AccelStepper works as before and can still be used alongside.
+template <uint8_t Interface, uint8_t Pin1, uint8_t Pin2, bool Pin1Inverted = false, bool Pin2Inverted = false>
+class AccelStepperT : public AccelStepperCore
+{
+public:
+    typedef AccelStepperInterface<Interface, Pin1, Pin2, Pin1Inverted, Pin2Inverted> Motor;
+
+    /// Constructor. As for AccelStepper, the motor pins are set to OUTPUT mode
+    /// by a call to enableOutputs() unless enable is false.
+    /// \param[in] enable If this is true (the default), enableOutputs() will be called to enable
+    /// the output pins at construction time.
+    AccelStepperT(bool enable = true)
+	: AccelStepperCore(&coreStep, (Interface == AccelStepper::DRIVER) ? &corePulseStart : 0, &corePulseEnd)
+    {
+	if (enable)
+	    enableOutputs();
+    }
+
+    /// As AccelStepper::run(), with the step issued inline
+    boolean run()
+    {
+	if (_timerAttached)
+	    return !_timerDone;
+	if (runSpeed())
+	    computeNewSpeed();
+	return _speed != 0.0 || distanceToGo() != 0;
+    }
+
+    /// As AccelStepper::runSpeed(), with the step issued inline
+    boolean runSpeed()
+    {
+	if (!stepDue())
+	    return false;
+	Motor::step(_currentPos, _direction, _minPulseWidth);
+	return true;
+    }
+
+    /// As AccelStepper::disableOutputs()
+    void disableOutputs()
+    {
+	Motor::disable();
+	if (_enablePin != 0xff)
+	{
+	    pinMode(_enablePin, OUTPUT);
+	    digitalWrite(_enablePin, LOW ^ _enableInverted);
+	}
+    }
+
+    /// As AccelStepper::enableOutputs()
+    void enableOutputs()
+    {
+	Motor::enable();
+	if (_enablePin != 0xff)
+	{
+	    pinMode(_enablePin, OUTPUT);
+	    digitalWrite(_enablePin, HIGH ^ _enableInverted);
+	}
+    }
+
+    /// As AccelStepper::setPinsInverted(), but only enableInvert has an effect
+    void setPinsInverted(bool directionInvert = false, bool stepInvert = false, bool enableInvert = false)
+    {
+	(void)(directionInvert); // Fixed by Pin2Inverted
+	(void)(stepInvert); // Fixed by Pin1Inverted
+	_enableInverted = enableInvert;
+    }
+
+private:
+    /// Steps issued from AccelStepperCore, eg by runToPosition(), AccelStepperQueue or the step timer interrupt
+    static void coreStep(AccelStepperCore* stepper, long step)
+    {
+	Motor::step(step, stepper->_direction, stepper->_minPulseWidth);
+    }
+
+    static void corePulseStart(AccelStepperCore* stepper)
+    {
+	Motor::pulseStart(stepper->_direction);
+    }
+
+    static void corePulseEnd(AccelStepperCore* stepper)
+    {
+	(void)(stepper); // Unused
+	Motor::pulseEnd();
+    }
+};
+
+#endif
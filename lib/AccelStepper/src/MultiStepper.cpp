@@ -7,10 +7,17 @@
 #include "AccelStepper.h"
 
 MultiStepper::MultiStepper()
-    : _num_steppers(0)
+    : _num_steppers(0),
+      _coordinated(false),
+      _leader(0)
 {
 }
 
+void MultiStepper::setCoordinated(boolean coordinated)
+{
+    _coordinated = coordinated;
+}
+
 boolean MultiStepper::addStepper(AccelStepper& stepper)
 {
     if (_num_steppers >= MULTISTEPPER_MAX_STEPPERS)
@@ -21,6 +28,35 @@ boolean MultiStepper::addStepper(AccelStepper& stepper)
 
 void MultiStepper::moveTo(long absolute[])
 {
+    if (_coordinated)
+    {
+	// The leader is the stepper with the most steps to take
+	uint8_t i;
+	long longestDistance = 0;
+	for (i = 0; i < _num_steppers; i++)
+	{
+	    _distance[i] = labs(absolute[i] - _steppers[i]->currentPosition());
+	    if (_distance[i] > longestDistance)
+	    {
+		longestDistance = _distance[i];
+		_leader = i;
+	    }
+	}
+	for (i = 0; i < _num_steppers; i++)
+	{
+	    AccelStepper* stepper = _steppers[i];
+	    // Start half way so each stepper's steps fall in the middle of their share of the leader's
+	    _error[i] = longestDistance / 2;
+	    if (i == _leader)
+		continue;
+	    // Followers never run their own profile: just set where they are going
+	    stepper->_targetPos = absolute[i];
+	    stepper->_direction = (absolute[i] > stepper->_currentPos) ? AccelStepper::DIRECTION_CW : AccelStepper::DIRECTION_CCW;
+	}
+	_steppers[_leader]->moveTo(absolute[_leader]);
+	return;
+    }
+
     // First find the stepper that will take the longest time to move
     float longestTime = 0.0;
 
@@ -51,6 +87,9 @@ void MultiStepper::moveTo(long absolute[])
 // Returns true if any motor is still running to the target position.
 boolean MultiStepper::run()
 {
+    if (_coordinated)
+	return runCoordinated();
+
     uint8_t i;
     boolean ret = false;
     for (i = 0; i < _num_steppers; i++)
@@ -77,6 +116,41 @@ boolean MultiStepper::run()
     return ret;
 }
 
+// Bresenham's line algorithm with the leader as the major axis: each leader step adds
+// every follower's distance to its error term, and the follower steps each time the
+// term passes the leader's distance
+boolean MultiStepper::runCoordinated()
+{
+    if (!_num_steppers)
+	return false;
+    AccelStepper* leader = _steppers[_leader];
+    if (leader->stepDue())
+    {
+	leader->step(leader->_currentPos);
+	leader->computeNewSpeed();
+
+	long leaderDistance = _distance[_leader];
+	uint8_t i;
+	for (i = 0; i < _num_steppers; i++)
+	{
+	    if (i == _leader)
+		continue;
+	    _error[i] += _distance[i];
+	    if (_error[i] >= leaderDistance)
+	    {
+		_error[i] -= leaderDistance;
+		AccelStepper* follower = _steppers[i];
+		if (follower->_direction == AccelStepper::DIRECTION_CW)
+		    follower->_currentPos += 1;
+		else
+		    follower->_currentPos -= 1;
+		follower->step(follower->_currentPos);
+	    }
+	}
+    }
+    return leader->_speed != 0.0 || leader->distanceToGo() != 0;
+}
+
 // Blocks until all steppers reach their target position and are stopped
 void    MultiStepper::runSpeedToPosition()
 { 
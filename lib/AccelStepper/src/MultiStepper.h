@@ -27,9 +27,16 @@ class AccelStepper;
 /// 3D printers etc
 /// to get linear straight line movement between arbitrary 2d (or 3d or ...) positions.
 ///
-/// Caution: only constant speed stepper motion is supported: acceleration and deceleration is not supported
+/// By default only constant speed stepper motion is supported: acceleration and deceleration is not supported
 /// All the steppers managed by MultiStepper will step at a constant speed to their
 /// target (albeit perhaps different speeds for each stepper).
+///
+/// In coordinated mode (see setCoordinated()) the whole group accelerates and decelerates together
+/// instead. The stepper with the furthest to go leads: it follows its own acceleration
+/// profile (trapezoidal, or S-curve if it has a jerk limit set with AccelStepper::setJerk()), and
+/// every other stepper takes its steps in between the leader's steps by Bresenham's line algorithm.
+/// The steps of each stepper therefore stay exactly proportional to its distance all the way,
+/// and all the steppers arrive at their targets together on the leader's last step.
 class MultiStepper
 {
 public:
@@ -50,9 +57,20 @@ public:
     /// the absolute position of the first stepper added by addStepper() etc. The array must be at least as long as 
     /// the number of steppers that have been added by addStepper, else results are undefined.
     void moveTo(long absolute[]);
+
+    /// Selects coordinated mode, where all managed steppers accelerate and decelerate together
+    /// on the acceleration profile of the stepper with the furthest to go.
+    /// The leader's maxSpeed() and acceleration are used for the whole group, so set them for
+    /// the slowest axis when it may lead. The other steppers speeds and accelerations are ignored.
+    /// Caution: call moveTo() only when all the steppers are stopped, and dont attach them
+    /// to the step timer with AccelStepper::attachTimer().
+    /// \param[in] coordinated true for coordinated mode, false (the default) for constant speed
+    void setCoordinated(boolean coordinated = true);
     
     /// Calls runSpeed() on all the managed steppers
     /// that have not acheived their target position.
+    /// In coordinated mode, steps the leader when its next step is due, then the other
+    /// steppers whose share of the move is due at that step.
     /// \return true if any stepper is still in the process of running to its target position.
     boolean run();
 
@@ -69,6 +87,22 @@ private:
     /// Number of steppers we are controlling and the number
     /// of steppers in _steppers[]
     uint8_t       _num_steppers;
+
+    /// True in coordinated mode
+    boolean       _coordinated;
+
+    /// Coordinated mode: index in _steppers[] of the stepper with the furthest to go
+    uint8_t       _leader;
+
+    /// Coordinated mode: absolute distance of the current move for each stepper
+    long          _distance[MULTISTEPPER_MAX_STEPPERS];
+
+    /// Coordinated mode: Bresenham error term for each stepper
+    long          _error[MULTISTEPPER_MAX_STEPPERS];
+
+    /// Runs one coordinated step of the group if the leader is due for one
+    /// \return true if any stepper is still in the process of running to its target position.
+    boolean       runCoordinated();
 };
 
 /// @example MultiStepper.pde
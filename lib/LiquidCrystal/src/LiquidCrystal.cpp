@@ -50,13 +50,27 @@ LiquidCrystal::LiquidCrystal(uint8_t rs,  uint8_t enable,
   init(1, rs, 255, enable, d0, d1, d2, d3, 0, 0, 0, 0);
 }
 
+LiquidCrystal::LiquidCrystal(LiquidCrystalTransport &transport)
+{
+  // unlike the pin constructors this does not call begin(), as the bus
+  // behind the transport may not work before setup()
+  _transport = &transport;
+  _rs_pin = 255;
+  _rw_pin = 255;
+  _enable_pin = 255;
+  initQueue();
+  _displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
+}
+
 void LiquidCrystal::init(uint8_t fourbitmode, uint8_t rs, uint8_t rw, uint8_t enable,
 			 uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3,
 			 uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7)
 {
+  _transport = 0;
   _rs_pin = rs;
   _rw_pin = rw;
   _enable_pin = enable;
+  initQueue();
   
   _data_pins[0] = d0;
   _data_pins[1] = d1;
@@ -76,6 +90,11 @@ void LiquidCrystal::init(uint8_t fourbitmode, uint8_t rs, uint8_t rw, uint8_t en
 }
 
 void LiquidCrystal::begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
+  // the initialisation sequence is timed with delays, so it is never queued
+  uint8_t queued = _queued;
+  setQueued(false);
+  _busyFlag = 0;  // not until the interface is set up
+
   if (lines > 1) {
     _displayfunction |= LCD_2LINE;
   }
@@ -88,28 +107,36 @@ void LiquidCrystal::begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
     _displayfunction |= LCD_5x10DOTS;
   }
 
-  pinMode(_rs_pin, OUTPUT);
-  // we can save 1 pin by not using RW. Indicate by passing 255 instead of pin#
-  if (_rw_pin != 255) { 
-    pinMode(_rw_pin, OUTPUT);
-  }
-  pinMode(_enable_pin, OUTPUT);
+  if (_transport) {
+    _transport->begin();
+  } else {
+    pinMode(_rs_pin, OUTPUT);
+    // we can save 1 pin by not using RW. Indicate by passing 255 instead of pin#
+    if (_rw_pin != 255) { 
+      pinMode(_rw_pin, OUTPUT);
+    }
+    pinMode(_enable_pin, OUTPUT);
   
-  // Do these once, instead of every time a character is drawn for speed reasons.
-  for (int i=0; i<((_displayfunction & LCD_8BITMODE) ? 8 : 4); ++i)
-  {
-    pinMode(_data_pins[i], OUTPUT);
-   } 
+    // Do these once, instead of every time a character is drawn for speed reasons.
+    for (int i=0; i<((_displayfunction & LCD_8BITMODE) ? 8 : 4); ++i)
+    {
+      pinMode(_data_pins[i], OUTPUT);
+      digitalWrite(_data_pins[i], LOW);  // also turns off any PWM, which the port writes would not
+     } 
+    mapPins();
+  }
 
   // SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
   // according to datasheet, we need at least 40ms after power rises above 2.7V
   // before sending commands. Arduino can turn on way before 4.5V so we'll wait 50
   delayMicroseconds(50000); 
   // Now we pull both RS and R/W low to begin commands
-  digitalWrite(_rs_pin, LOW);
-  digitalWrite(_enable_pin, LOW);
-  if (_rw_pin != 255) { 
-    digitalWrite(_rw_pin, LOW);
+  if (!_transport) {
+    digitalWrite(_rs_pin, LOW);
+    digitalWrite(_enable_pin, LOW);
+    if (_rw_pin != 255) { 
+      digitalWrite(_rw_pin, LOW);
+    }
   }
   
   //put the LCD into 4 bit or 8 bit mode
@@ -162,6 +189,9 @@ void LiquidCrystal::begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
   // set the entry mode
   command(LCD_ENTRYMODESET | _displaymode);
 
+  // with RW wired we can ask the LCD when it is done instead of waiting the worst case
+  _busyFlag = (_rw_pin != 255);
+  setQueued(queued);
 }
 
 void LiquidCrystal::setRowOffsets(int row0, int row1, int row2, int row3)
@@ -176,13 +206,17 @@ void LiquidCrystal::setRowOffsets(int row0, int row1, int row2, int row3)
 void LiquidCrystal::clear()
 {
   command(LCD_CLEARDISPLAY);  // clear display, set cursor position to zero
-  delayMicroseconds(2000);  // this command takes a long time!
+  if (!_queued) {
+    waitReady(2000);  // this command takes a long time! poll() waits for it when queued
+  }
 }
 
 void LiquidCrystal::home()
 {
   command(LCD_RETURNHOME);  // set cursor position to zero
-  delayMicroseconds(2000);  // this command takes a long time!
+  if (!_queued) {
+    waitReady(2000);  // this command takes a long time! poll() waits for it when queued
+  }
 }
 
 void LiquidCrystal::setCursor(uint8_t col, uint8_t row)
@@ -281,16 +315,139 @@ inline size_t LiquidCrystal::write(uint8_t value) {
   return 1; // assume sucess
 }
 
+// print() comes here, so a transport can send a whole string in one go
+size_t LiquidCrystal::write(const uint8_t *buffer, size_t size) {
+  if (_transport && !_queued) {
+    _transport->send(buffer, size, HIGH);
+    return size;
+  }
+  return Print::write(buffer, size);
+}
+
+/*********** queued mode */
+
+void LiquidCrystal::initQueue() {
+  _busyFlag = 0;
+  _queued = 0;
+  _queueHead = 0;
+  _queueCount = 0;
+  _queueLowNibble = 0;
+  _queueTime = 0;
+  _queueWait = 0;
+}
+
+void LiquidCrystal::setQueued(bool queued) {
+  if (!queued) {
+    flush();
+  }
+  _queued = queued;
+}
+
+// Sends the next nibble if the LCD has had time to finish the last one.
+// Bytes go out strictly in order, so a clear or home holds back everything
+// after it until its long wait is over.
+void LiquidCrystal::poll() {
+  if (_queueCount == 0) {
+    return;
+  }
+  if ((micros() - _queueTime) < _queueWait) {
+    if (!_busyFlag || readBusy()) {
+      return;
+    }
+    _queueWait = 0;  // the LCD says it is done early
+  }
+
+  uint16_t entry = _queue[_queueHead];
+  uint8_t value = entry;
+  uint8_t mode = entry >> 8;
+
+  if (_transport) {
+    _transport->send(&value, 1, mode);  // a whole byte, the transport has no nibbles to split
+  } else {
+    if (!(_displayfunction & LCD_8BITMODE) && !_queueLowNibble) {
+      writeRs(mode);
+      if (_rw_pin != 255) { 
+        digitalWrite(_rw_pin, LOW);
+      }
+      writeDataPins(value >> 4, 4);
+      strobeEnable();
+      _queueLowNibble = 1;
+      _queueTime = micros();
+      _queueWait = 0;  // the low nibble can follow straight away
+      return;
+    }
+
+    if (_displayfunction & LCD_8BITMODE) {
+      writeRs(mode);
+      if (_rw_pin != 255) { 
+        digitalWrite(_rw_pin, LOW);
+      }
+      writeDataPins(value, 8);
+    } else {
+      writeDataPins(value, 4);
+    }
+    strobeEnable();
+  }
+  _queueLowNibble = 0;
+  _queueTime = micros();
+  // clear and home take a long time, everything else > 37us like pulseEnable()
+  _queueWait = (mode == LOW && (value == LCD_CLEARDISPLAY || (value & ~1) == LCD_RETURNHOME)) ? 2000 : 100;
+
+  _queueHead = (_queueHead + 1) % LCD_QUEUE_LENGTH;
+  _queueCount--;
+}
+
+void LiquidCrystal::flush() {
+  while (_queueCount) {
+    poll();
+  }
+  while ((micros() - _queueTime) < _queueWait) {
+    // let the last command finish
+  }
+}
+
+uint8_t LiquidCrystal::queued() {
+  return _queueCount;
+}
+
 /************ low level data pushing commands **********/
 
 // write either command or data, with automatic 4/8-bit selection
 void LiquidCrystal::send(uint8_t value, uint8_t mode) {
-  digitalWrite(_rs_pin, mode);
+  if (_queued) {
+    while (_queueCount >= LCD_QUEUE_LENGTH) {
+      poll();  // full, wait for room
+    }
+    _queue[(_queueHead + _queueCount) % LCD_QUEUE_LENGTH] = value | ((uint16_t)mode << 8);
+    _queueCount++;
+    return;
+  }
+
+  if (_transport) {
+    _transport->send(&value, 1, mode);
+    return;
+  }
+
+  writeRs(mode);
 
   // if there is a RW pin indicated, set it low to Write
   if (_rw_pin != 255) { 
     digitalWrite(_rw_pin, LOW);
   }
+
+  if (_busyFlag) {
+    // no fixed delays, not even between the nibbles: wait once the whole byte is in
+    if (_displayfunction & LCD_8BITMODE) {
+      writeDataPins(value, 8);
+    } else {
+      writeDataPins(value >> 4, 4);
+      strobeEnable();
+      writeDataPins(value, 4);
+    }
+    strobeEnable();
+    waitReady(100);
+    return;
+  }
   
   if (_displayfunction & LCD_8BITMODE) {
     write8bits(value); 
@@ -301,26 +458,155 @@ void LiquidCrystal::send(uint8_t value, uint8_t mode) {
 }
 
 void LiquidCrystal::pulseEnable(void) {
-  digitalWrite(_enable_pin, LOW);
+  strobeEnable();
+  delayMicroseconds(100);   // commands need > 37us to settle
+}
+
+// the enable pulse on its own, without waiting for the LCD to act on it
+void LiquidCrystal::strobeEnable(void) {
+  writeEnable(LOW);
   delayMicroseconds(1);    
-  digitalWrite(_enable_pin, HIGH);
+  writeEnable(HIGH);
   delayMicroseconds(1);    // enable pulse must be >450ns
-  digitalWrite(_enable_pin, LOW);
-  delayMicroseconds(100);   // commands need > 37us to settle
+  writeEnable(LOW);
 }
 
-void LiquidCrystal::write4bits(uint8_t value) {
-  for (int i = 0; i < 4; i++) {
-    digitalWrite(_data_pins[i], (value >> i) & 0x01);
+// Reads the busy flag (DB7). In 4 bit mode the second nibble, the rest of the
+// address counter, is clocked out as well so reads stay in step.
+uint8_t LiquidCrystal::readBusy(void) {
+  uint8_t count = (_displayfunction & LCD_8BITMODE) ? 8 : 4;
+  for (int i = 0; i < count; i++) {
+    pinMode(_data_pins[i], INPUT);
+  }
+  writeRs(LOW);
+  digitalWrite(_rw_pin, HIGH);
+
+  writeEnable(HIGH);
+  delayMicroseconds(1);    // data is valid 360ns after enable
+  uint8_t busy = digitalRead(_data_pins[count - 1]);
+  writeEnable(LOW);
+  if (count == 4) {
+    delayMicroseconds(1);
+    writeEnable(HIGH);
+    delayMicroseconds(1);
+    writeEnable(LOW);
   }
 
+  digitalWrite(_rw_pin, LOW);
+  for (int i = 0; i < count; i++) {
+    pinMode(_data_pins[i], OUTPUT);
+  }
+  return busy;
+}
+
+// Waits until the LCD is done with the last command, or for the fixed delay
+// of us microseconds if it cannot tell us. If the busy flag is still set once
+// the fixed delay is over we go on anyway, as if it were not wired.
+void LiquidCrystal::waitReady(unsigned int us) {
+  if (!_busyFlag) {
+    delayMicroseconds(us);
+    return;
+  }
+  unsigned long start = micros();
+  while (readBusy()) {
+    if ((micros() - start) >= us) {
+      return;
+    }
+  }
+}
+
+void LiquidCrystal::write4bits(uint8_t value) {
+  if (_transport) {
+    _transport->write4bits(value);
+    delayMicroseconds(100);
+    return;
+  }
+  writeDataPins(value, 4);
   pulseEnable();
 }
 
 void LiquidCrystal::write8bits(uint8_t value) {
-  for (int i = 0; i < 8; i++) {
+  writeDataPins(value, 8);
+  pulseEnable();
+}
+
+void LiquidCrystal::writeDataPins(uint8_t value, uint8_t count) {
+#if defined(ARDUINO_ARCH_AVR)
+  if (count == 4 && _data_port) {
+    // one masked store, in whatever order the pins are on the port
+    uint8_t oldSREG = SREG;
+    cli();
+    *_data_port = (*_data_port & ~_data_mask) | _nibble_bits[value & 0x0f];
+    SREG = oldSREG;
+    return;
+  }
+#endif
+  for (int i = 0; i < count; i++) {
     digitalWrite(_data_pins[i], (value >> i) & 0x01);
   }
-  
-  pulseEnable();
+}
+
+// Looks up the port registers of RS, enable and the data pins so the low level
+// writes need not go through digitalWrite(). In 4 bit mode, if the data pins
+// are all on one port, the port bits for each nibble value are worked out
+// here once, so a nibble is a single masked store.
+void LiquidCrystal::mapPins() {
+#if defined(ARDUINO_ARCH_AVR)
+  _rs_port = portOutputRegister(digitalPinToPort(_rs_pin));
+  _rs_mask = digitalPinToBitMask(_rs_pin);
+  _enable_port = portOutputRegister(digitalPinToPort(_enable_pin));
+  _enable_mask = digitalPinToBitMask(_enable_pin);
+
+  _data_port = 0;
+  if (_displayfunction & LCD_8BITMODE) {
+    return;
+  }
+  uint8_t port = digitalPinToPort(_data_pins[0]);
+  _data_mask = 0;
+  for (int i = 0; i < 4; i++) {
+    if (digitalPinToPort(_data_pins[i]) != port) {
+      return;  // spread over ports, stay with digitalWrite()
+    }
+    _data_mask |= digitalPinToBitMask(_data_pins[i]);
+  }
+  for (int nibble = 0; nibble < 16; nibble++) {
+    _nibble_bits[nibble] = 0;
+    for (int i = 0; i < 4; i++) {
+      if ((nibble >> i) & 0x01) {
+        _nibble_bits[nibble] |= digitalPinToBitMask(_data_pins[i]);
+      }
+    }
+  }
+  _data_port = portOutputRegister(port);
+#endif
+}
+
+void LiquidCrystal::writeRs(uint8_t mode) {
+#if defined(ARDUINO_ARCH_AVR)
+  uint8_t oldSREG = SREG;
+  cli();
+  if (mode) {
+    *_rs_port |= _rs_mask;
+  } else {
+    *_rs_port &= ~_rs_mask;
+  }
+  SREG = oldSREG;
+#else
+  digitalWrite(_rs_pin, mode);
+#endif
+}
+
+void LiquidCrystal::writeEnable(uint8_t level) {
+#if defined(ARDUINO_ARCH_AVR)
+  uint8_t oldSREG = SREG;
+  cli();
+  if (level) {
+    *_enable_port |= _enable_mask;
+  } else {
+    *_enable_port &= ~_enable_mask;
+  }
+  SREG = oldSREG;
+#else
+  digitalWrite(_enable_pin, level);
+#endif
 }
@@ -42,6 +42,21 @@
 #define LCD_5x10DOTS 0x04
 #define LCD_5x8DOTS 0x00
 
+// bytes setQueued() mode can hold before a write has to wait for room
+#ifndef LCD_QUEUE_LENGTH
+#define LCD_QUEUE_LENGTH 32
+#endif
+
+// Carries bytes to the LCD in place of LiquidCrystal's own pins, e.g. through
+// an I2C port expander (see the LiquidCrystalPCF8574 library). Always 4 bit
+// mode and without RW, so there is no busy flag.
+class LiquidCrystalTransport {
+public:
+  virtual void begin() = 0; // set up the bus with enable and RS low, from LiquidCrystal::begin()
+  virtual void write4bits(uint8_t value) = 0; // one nibble with RS low, for the init sequence
+  virtual void send(const uint8_t *values, size_t count, uint8_t mode) = 0; // bytes with RS at mode, in as few transfers as the bus allows
+};
+
 class LiquidCrystal : public Print {
 public:
   LiquidCrystal(uint8_t rs, uint8_t enable,
@@ -54,6 +69,7 @@ public:
 		uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3);
   LiquidCrystal(uint8_t rs, uint8_t enable,
 		uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3);
+  LiquidCrystal(LiquidCrystalTransport &transport); // nothing is sent until begin()
 
   void init(uint8_t fourbitmode, uint8_t rs, uint8_t rw, uint8_t enable,
 	    uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3,
@@ -81,14 +97,33 @@ public:
   void createChar(uint8_t, uint8_t[]);
   void setCursor(uint8_t, uint8_t); 
   virtual size_t write(uint8_t);
+  virtual size_t write(const uint8_t *buffer, size_t size);
   void command(uint8_t);
+
+  // In queued mode writes and commands return at once and poll() sends
+  // them one nibble at a time, never waiting for the LCD. Turning it off
+  // sends whatever is still queued first.
+  void setQueued(bool queued = true);
+  void poll();
+  void flush();     // waits until everything queued has been sent
+  uint8_t queued(); // bytes still to send
   
   using Print::write;
 private:
   void send(uint8_t, uint8_t);
   void write4bits(uint8_t);
   void write8bits(uint8_t);
+  void writeDataPins(uint8_t, uint8_t);
+  void mapPins();
+  void initQueue();
+  void writeRs(uint8_t);
+  void writeEnable(uint8_t);
   void pulseEnable();
+  void strobeEnable();
+  uint8_t readBusy();
+  void waitReady(unsigned int);
+
+  LiquidCrystalTransport *_transport; // 0 when using the pins below
 
   uint8_t _rs_pin; // LOW: command.  HIGH: character.
   uint8_t _rw_pin; // LOW: write to LCD.  HIGH: read from LCD.
@@ -100,9 +135,29 @@ private:
   uint8_t _displaymode;
 
   uint8_t _initialized;
+  uint8_t _busyFlag; // set once begin() is done if RW is wired, see waitReady()
 
   uint8_t _numlines;
   uint8_t _row_offsets[4];
+
+#if defined(ARDUINO_ARCH_AVR)
+  // port registers looked up by begin(), see mapPins()
+  volatile uint8_t *_rs_port;
+  uint8_t _rs_mask;
+  volatile uint8_t *_enable_port;
+  uint8_t _enable_mask;
+  volatile uint8_t *_data_port; // 0 unless the 4 data pins share a port
+  uint8_t _data_mask;
+  uint8_t _nibble_bits[16]; // port bits to set for each nibble
+#endif
+
+  uint8_t _queued; // set by setQueued()
+  uint16_t _queue[LCD_QUEUE_LENGTH]; // byte to send, with the RS level in bit 8
+  uint8_t _queueHead;
+  uint8_t _queueCount;
+  uint8_t _queueLowNibble; // high nibble of the head byte already sent
+  unsigned long _queueTime; // micros() at the last nibble sent
+  unsigned int _queueWait; // microseconds the LCD needs after it
 };
 
 #endif
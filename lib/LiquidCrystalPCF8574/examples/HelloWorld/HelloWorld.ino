@@ -0,0 +1,26 @@
+/*
+  LiquidCrystalPCF8574 - Hello World
+
+ Prints "hello, world!" and the seconds since reset on a 16x2 LCD
+ behind a PCF8574 I2C backpack, using the LiquidCrystal library.
+
+  The circuit:
+ * backpack SDA to A4, SCL to A5
+ * backpack VCC to 5V, GND to ground
+*/
+
+#include <LiquidCrystal.h>
+#include <LiquidCrystalPCF8574.h>
+
+LiquidCrystalPCF8574 expander(0x27);  // 0x3F on some backpacks
+LiquidCrystal lcd(expander);
+
+void setup() {
+  lcd.begin(16, 2);
+  lcd.print("hello, world!");
+}
+
+void loop() {
+  lcd.setCursor(0, 1);
+  lcd.print(millis() / 1000);
+}
@@ -0,0 +1,63 @@
+#include "LiquidCrystalPCF8574.h"
+
+#include <Wire.h>
+
+LiquidCrystalPCF8574::LiquidCrystalPCF8574(uint8_t address)
+{
+  _address = address;
+  _backlight = PCF8574_LCD_BACKLIGHT;
+}
+
+void LiquidCrystalPCF8574::begin()
+{
+  Wire.begin();
+  transmit(&_backlight, 1); // everything else low
+}
+
+void LiquidCrystalPCF8574::write4bits(uint8_t value)
+{
+  uint8_t bits = _backlight | (value << 4);
+  uint8_t data[3] = { _backlight, (uint8_t)(bits | PCF8574_LCD_ENABLE), bits };
+  transmit(data, sizeof(data));
+}
+
+void LiquidCrystalPCF8574::send(const uint8_t *values, size_t count, uint8_t mode)
+{
+  uint8_t control = _backlight | (mode ? PCF8574_LCD_RS : 0);
+  uint8_t data[PCF8574_LCD_TRANSFER];
+
+  while (count) {
+    uint8_t n = 0;
+    data[n++] = control; // RS settles before the first enable edge
+    while (count && n + 4 <= PCF8574_LCD_TRANSFER) {
+      uint8_t high = control | (*values & 0xf0);
+      uint8_t low = control | (*values << 4);
+      data[n++] = high | PCF8574_LCD_ENABLE;
+      data[n++] = high;
+      data[n++] = low | PCF8574_LCD_ENABLE;
+      data[n++] = low;
+      values++;
+      count--;
+    }
+    transmit(data, n);
+  }
+}
+
+void LiquidCrystalPCF8574::backlight()
+{
+  _backlight = PCF8574_LCD_BACKLIGHT;
+  transmit(&_backlight, 1);
+}
+
+void LiquidCrystalPCF8574::noBacklight()
+{
+  _backlight = 0;
+  transmit(&_backlight, 1);
+}
+
+void LiquidCrystalPCF8574::transmit(const uint8_t *data, uint8_t count)
+{
+  Wire.beginTransmission(_address);
+  Wire.write(data, count);
+  Wire.endTransmission();
+}
@@ -0,0 +1,51 @@
+#ifndef LiquidCrystalPCF8574_h
+#define LiquidCrystalPCF8574_h
+
+#include <inttypes.h>
+#include <LiquidCrystal.h>
+
+// expander pins of the common backpack
+#define PCF8574_LCD_RS        0x01
+#define PCF8574_LCD_RW        0x02
+#define PCF8574_LCD_ENABLE    0x04
+#define PCF8574_LCD_BACKLIGHT 0x08 // D4-D7 are on the high nibble
+
+// bytes in one I2C transfer, the size of the Wire buffer
+#ifndef PCF8574_LCD_TRANSFER
+#define PCF8574_LCD_TRANSFER 32
+#endif
+
+// LiquidCrystal transport for an LCD on a PCF8574 I2C backpack:
+//
+//   LiquidCrystalPCF8574 expander(0x27);
+//   LiquidCrystal lcd(expander);
+//
+// Every enable edge is a write to the expander port. Each transfer starts with
+// one byte that sets RS with enable low, then sends an enable high and an
+// enable low byte for each nibble. A run of characters is packed 7 to a
+// transfer, instead of one transfer per edge. The bus does the timing: even
+// at 400 kHz an enable pulse lasts a whole byte (22 us), and the next
+// character is not latched until two bytes after the last one, which covers
+// the 37 us the LCD needs.
+class LiquidCrystalPCF8574 : public LiquidCrystalTransport {
+public:
+  LiquidCrystalPCF8574(uint8_t address = 0x27);
+
+  virtual void begin();
+  virtual void write4bits(uint8_t value);
+  virtual void send(const uint8_t *values, size_t count, uint8_t mode);
+
+  void backlight();
+  void noBacklight();
+
+protected:
+  // Writes count bytes to the expander port in one I2C transfer. Override it
+  // to drive a stand-in for the expander, e.g. in a test on the host.
+  virtual void transmit(const uint8_t *data, uint8_t count);
+
+private:
+  uint8_t _address;
+  uint8_t _backlight; // PCF8574_LCD_BACKLIGHT or 0, kept in every byte
+};
+
+#endif
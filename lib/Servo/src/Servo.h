@@ -43,6 +43,13 @@
     readMicroseconds()   - Gets the last written servo pulse width in microseconds. (was read_us() in first release)
     attached()  - Returns true if there is a servo attached. 
     detach()    - Stops an attached servos from pulsing its i/o pin. 
+    writeTicks() - Sets the servo pulse width in timer ticks, the unit the ISR uses, so no conversion is needed (AVR only).
+                  Given a rate as well, the ISR moves the pulse width towards the new value by that much each refresh
+                  interval, so smooth moves need no further writes from the sketch. isMoving() tells when it gets there.
+    readTicks() - Gets the servo pulse width in timer ticks (AVR only).
+    setRefreshInterval() - Sets how often the servos on this servo's timer are pulsed, in microseconds (AVR only).
+                  Digital servos can take much faster updates than the default of REFRESH_INTERVAL. The interval is
+                  raised if needed to fit MAX_PULSE_WIDTH for every servo on the timer, and capped at MAX_REFRESH_INTERVAL.
  */
 
 #ifndef Servo_h
@@ -82,7 +89,10 @@
 #define MIN_PULSE_WIDTH       544     // the shortest pulse sent to a servo  
 #define MAX_PULSE_WIDTH      2400     // the longest pulse sent to a servo 
 #define DEFAULT_PULSE_WIDTH  1500     // default pulse width when servo is attached
-#define REFRESH_INTERVAL    20000     // minumim time to refresh servos in microseconds 
+#ifndef REFRESH_INTERVAL
+#define REFRESH_INTERVAL    20000     // minumim time to refresh servos in microseconds, can be changed with setRefreshInterval() on AVR
+#endif
+#define MAX_REFRESH_INTERVAL 32000    // longest refresh interval setRefreshInterval() accepts, fits in the 16 bit timer at 0.5 us a tick
 
 #define SERVOS_PER_TIMER       12     // the maximum number of servos controlled by one timer 
 #define MAX_SERVOS   (_Nbr_16timers  * SERVOS_PER_TIMER)
@@ -99,6 +109,13 @@ typedef struct  {
 typedef struct {
   ServoPin_t Pin;
   volatile unsigned int ticks;
+#if defined(ARDUINO_ARCH_AVR)
+  volatile uint8_t *outReg;           // output port register of Pin.nbr, looked up at attach()
+  uint8_t bitMask;                    // bit of Pin.nbr in outReg
+  volatile unsigned int target;       // ticks the ISR moves towards, rate ticks each refresh
+  volatile unsigned int rate;         // 8.8 fixed point ticks per refresh interval
+  uint8_t frac;                       // fraction of a tick carried over to the next refresh
+#endif
 } servo_t;
 
 class Servo
@@ -113,6 +130,16 @@ public:
   int read();                        // returns current pulse width as an angle between 0 and 180 degrees
   int readMicroseconds();            // returns current pulse width in microseconds for this servo (was read_us() in first release)
   bool attached();                   // return true if this servo is attached, otherwise false 
+#if defined(ARDUINO_ARCH_AVR)
+  void writeTicks(unsigned int ticks); // Write pulse width in timer ticks (0.5 us at 16 MHz), not limited to the min and max values
+  void writeTicks(unsigned int ticks, unsigned int rate); // move the pulse width to ticks at rate, in 1/256 ticks per refresh interval, from the ISR
+  unsigned int readTicks();          // returns current pulse width in timer ticks, which the ISR changes while moving
+  bool isMoving();                   // true until the ISR reaches the ticks given to writeTicks() with a rate
+  unsigned int microsecondsToTicks(int value); // converts a pulse width to ticks the way writeMicroseconds() does, limited to min and max
+  unsigned int ticksRate(unsigned int usPerSecond); // converts a speed in microseconds of pulse width per second to a writeTicks() rate at the current refresh interval
+  unsigned int setRefreshInterval(unsigned int us); // sets the refresh interval of the timer driving this servo, returns the interval in microseconds actually used
+  unsigned int refreshInterval();    // returns the refresh interval in microseconds of the timer driving this servo
+#endif
 private:
    uint8_t servoIndex;               // index into the channel data for this servo
    int8_t min;                       // minimum is this value times 4 added to MIN_PULSE_WIDTH    
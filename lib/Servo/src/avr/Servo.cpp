@@ -37,6 +37,9 @@ static volatile int8_t Channel[_Nbr_16timers ];             // counter for the s
 
 uint8_t ServoCount = 0;                                     // the total number of attached servos
 
+static unsigned int refreshRequest[_Nbr_16timers];          // refresh interval in us asked for with setRefreshInterval(), 0 for REFRESH_INTERVAL
+static volatile unsigned int refreshTicks[_Nbr_16timers];   // refresh interval in ticks used by the ISR, see updateRefresh()
+
 
 // convenience macros
 #define SERVO_INDEX_TO_TIMER(_servo_nbr) ((timer16_Sequence_t)(_servo_nbr / SERVOS_PER_TIMER)) // returns the timer controlling this servo
@@ -49,31 +52,131 @@ uint8_t ServoCount = 0;                                     // the total number
 
 /************ static functions common to all instances ***********************/
 
+// Moves a channel one refresh interval's worth towards the target given to writeTicks(), called from
+// the ISR as the channel's pulse starts. The whole ticks of rate are added each time and its fraction
+// is accumulated in frac, carrying a tick when it overflows.
+static inline void stepTicks(servo_t *servo)
+{
+  unsigned int ticks = servo->ticks;
+  unsigned int target = servo->target;
+  unsigned int rate = servo->rate;
+  unsigned int step = rate >> 8;
+  uint8_t frac = servo->frac + (uint8_t)rate;
+  if( frac < (uint8_t)rate )
+    step++;                                   // the fraction wrapped
+  if( ticks < target )
+    ticks = (target - ticks > step) ? ticks + step : target;
+  else
+    ticks = (ticks - target > step) ? ticks - step : target;
+  servo->frac = frac;
+  servo->ticks = ticks;
+}
+
+// The pins are written straight to the port registers cached in servo_t by attach(), so each edge
+// is a single read-modify-write (interrupts are off in here). Unlike digitalWrite() this does not turn
+// off PWM on the pin, so dont use analogWrite() on servo pins.
 static inline void handle_interrupts(timer16_Sequence_t timer, volatile uint16_t *TCNTn, volatile uint16_t* OCRnA)
 {
-  if( Channel[timer] < 0 )
+  int8_t channel = Channel[timer];
+  servo_t *servo;
+  if( channel < 0 )
     *TCNTn = 0; // channel set to -1 indicated that refresh interval completed so reset the timer
   else{
-    if( SERVO_INDEX(timer,Channel[timer]) < ServoCount && SERVO(timer,Channel[timer]).Pin.isActive == true )
-      digitalWrite( SERVO(timer,Channel[timer]).Pin.nbr,LOW); // pulse this channel low if activated
+    servo = &SERVO(timer,channel);
+    if( SERVO_INDEX(timer,channel) < ServoCount && servo->Pin.isActive == true )
+      *servo->outReg &= ~servo->bitMask; // pulse this channel low if activated
   }
 
-  Channel[timer]++;    // increment to the next channel
-  if( SERVO_INDEX(timer,Channel[timer]) < ServoCount && Channel[timer] < SERVOS_PER_TIMER) {
-    *OCRnA = *TCNTn + SERVO(timer,Channel[timer]).ticks;
-    if(SERVO(timer,Channel[timer]).Pin.isActive == true)     // check if activated
-      digitalWrite( SERVO(timer,Channel[timer]).Pin.nbr,HIGH); // its an active channel so pulse it high
+  channel++;    // increment to the next channel
+  Channel[timer] = channel;
+  if( SERVO_INDEX(timer,channel) < ServoCount && channel < SERVOS_PER_TIMER) {
+    servo = &SERVO(timer,channel);
+    if( servo->ticks != servo->target )
+      stepTicks(servo);                 // moving, see writeTicks()
+    *OCRnA = *TCNTn + servo->ticks;
+    if(servo->Pin.isActive == true)     // check if activated
+      *servo->outReg |= servo->bitMask; // its an active channel so pulse it high
   }
   else {
     // finished all channels so wait for the refresh period to expire before starting over
-    if( ((unsigned)*TCNTn) + 4 < usToTicks(REFRESH_INTERVAL) )  // allow a few ticks to ensure the next OCR1A not missed
-      *OCRnA = (unsigned int)usToTicks(REFRESH_INTERVAL);
+    if( ((unsigned)*TCNTn) + 4 < refreshTicks[timer] )  // allow a few ticks to ensure the next OCR1A not missed
+      *OCRnA = refreshTicks[timer];
     else
       *OCRnA = *TCNTn + 4;  // at least REFRESH_INTERVAL has elapsed
     Channel[timer] = -1; // this will get incremented at the end of the refresh period to start again at the first channel
   }
 }
 
+#if defined(_useTimer2)
+// Timer2 only counts to 255 (128 us at prescale 8), so it free runs in normal mode and each 16 bit
+// interval is counted as a number of whole compare match cycles to skip plus a final partial one.
+// Intervals are measured from when each edge was due, not from when the interrupt ran, and
+// timer2Frame keeps the time since the start of the refresh period that TCNT1 holds for Timer1.
+#define TIMER2_MIN_TICKS  16                  // shortest interval we can schedule from inside the ISR
+
+static volatile uint8_t timer2Wraps;          // compare matches to skip before the next edge
+static uint16_t timer2Frame;                  // ticks from the start of the refresh period to the edge being handled
+
+// Schedules the next compare match ticks after the one being handled
+static inline void timer2Schedule(uint16_t ticks)
+{
+  uint8_t now = TCNT2;
+  uint8_t late = now - OCR2A;                 // ticks since the match we are handling
+  uint16_t remaining = (ticks > late + TIMER2_MIN_TICKS) ? ticks - late : TIMER2_MIN_TICKS;
+  uint8_t first = remaining & 0xff;           // ticks to the first match, or 256 if 0
+  OCR2A = now + first;
+  timer2Wraps = (remaining - 1) >> 8;
+  // The first match went by before OCR2A was written if the counter is past it but no match
+  // is pending. If the match did happen after the write, its interrupt counts off the wrap itself
+  if( first != 0 && (uint8_t)(TCNT2 - now) >= first && !(TIFR2 & _BV(OCF2A)) && timer2Wraps > 0 )
+    timer2Wraps--;
+}
+
+static inline void handle_interrupts_timer2()
+{
+  if( timer2Wraps ) {
+    timer2Wraps--;                            // not there yet
+    return;
+  }
+
+  int8_t channel = Channel[_timer2];
+  servo_t *servo;
+  if( channel < 0 )
+    timer2Frame = 0; // channel set to -1 indicated that refresh interval completed so start a new period
+  else{
+    servo = &SERVO(_timer2,channel);
+    if( SERVO_INDEX(_timer2,channel) < ServoCount && servo->Pin.isActive == true )
+      *servo->outReg &= ~servo->bitMask; // pulse this channel low if activated
+  }
+
+  channel++;    // increment to the next channel
+  Channel[_timer2] = channel;
+  if( SERVO_INDEX(_timer2,channel) < ServoCount && channel < SERVOS_PER_TIMER) {
+    servo = &SERVO(_timer2,channel);
+    if( servo->ticks != servo->target )
+      stepTicks(servo);                 // moving, see writeTicks()
+    if(servo->Pin.isActive == true)     // check if activated
+      *servo->outReg |= servo->bitMask; // its an active channel so pulse it high
+    unsigned int ticks = servo->ticks;
+    timer2Frame += ticks;
+    timer2Schedule(ticks);
+  }
+  else {
+    // finished all channels so wait for the refresh period to expire before starting over
+    if( (unsigned long)timer2Frame + TIMER2_MIN_TICKS < refreshTicks[_timer2] )
+      timer2Schedule(refreshTicks[_timer2] - timer2Frame);
+    else
+      timer2Schedule(TIMER2_MIN_TICKS);  // at least REFRESH_INTERVAL has elapsed
+    Channel[_timer2] = -1; // this will get incremented at the end of the refresh period to start again at the first channel
+  }
+}
+
+SIGNAL (TIMER2_COMPA_vect)
+{
+  handle_interrupts_timer2();
+}
+#endif
+
 #ifndef WIRING // Wiring pre-defines signal handlers so don't define any if compiling for the Wiring platform
 // Interrupt handlers for Arduino
 #if defined(_useTimer1)
@@ -123,6 +226,18 @@ void Timer3Service()
 
 static void initISR(timer16_Sequence_t timer)
 {
+#if defined (_useTimer2)
+  if(timer == _timer2) {
+    TCCR2A = 0;             // normal counting mode
+    TCCR2B = _BV(CS21);     // set prescaler of 8
+    TCNT2 = 0;              // clear the timer count
+    OCR2A = TIMER2_MIN_TICKS;
+    timer2Wraps = 0;
+    TIFR2 = _BV(OCF2A);     // clear any pending interrupts;
+    TIMSK2 |=  _BV(OCIE2A) ; // enable the output compare interrupt
+  }
+#endif
+
 #if defined (_useTimer1)
   if(timer == _timer1) {
     TCCR1A = 0;             // normal counting mode
@@ -184,7 +299,12 @@ static void initISR(timer16_Sequence_t timer)
 static void finISR(timer16_Sequence_t timer)
 {
     //disable use of the given timer
-#if defined WIRING   // Wiring
+#if defined (_useTimer2)
+  if(timer == _timer2) {
+    TIMSK2 &= ~_BV(OCIE2A);  // disable the timer2 output compare A interrupt
+    TCCR2B = 0;              // and stop the timer
+  }
+#elif defined WIRING   // Wiring
   if(timer == _timer1) {
     #if defined(__AVR_ATmega1281__)||defined(__AVR_ATmega2561__)
     TIMSK1 &=  ~_BV(OCIE1A) ;  // disable timer 1 output compare interrupt
@@ -207,6 +327,26 @@ static void finISR(timer16_Sequence_t timer)
 #endif
 }
 
+// Works out the refresh interval the ISR uses for this timer. Every channel on the timer is given its
+// pulse width in turn before the refresh period can start again, so the interval is raised to fit
+// MAX_PULSE_WIDTH for each of them; a frame that overruns anyway just starts the next one a few ticks late.
+static void updateRefresh(timer16_Sequence_t timer)
+{
+  unsigned int us = refreshRequest[timer] ? refreshRequest[timer] : REFRESH_INTERVAL;
+  int channels = ServoCount - timer * SERVOS_PER_TIMER;     // servos pulsed by handle_interrupts() on this timer
+  if(channels > SERVOS_PER_TIMER)
+    channels = SERVOS_PER_TIMER;
+  if(channels > 0 && us < (unsigned int)channels * MAX_PULSE_WIDTH)
+    us = (unsigned int)channels * MAX_PULSE_WIDTH;
+  if(us > MAX_REFRESH_INTERVAL)
+    us = MAX_REFRESH_INTERVAL;
+
+  uint8_t oldSREG = SREG;
+  cli();
+  refreshTicks[timer] = usToTicks(us);
+  SREG = oldSREG;
+}
+
 static boolean isTimerActive(timer16_Sequence_t timer)
 {
   // returns true if any servo is active on this timer
@@ -225,6 +365,7 @@ Servo::Servo()
   if( ServoCount < MAX_SERVOS) {
     this->servoIndex = ServoCount++;                    // assign a servo index to this instance
 	servos[this->servoIndex].ticks = usToTicks(DEFAULT_PULSE_WIDTH);   // store default values  - 12 Aug 2009
+    servos[this->servoIndex].target = servos[this->servoIndex].ticks;  // not moving
   }
   else
     this->servoIndex = INVALID_SERVO ;  // too many servos
@@ -240,11 +381,14 @@ uint8_t Servo::attach(int pin, int min, int max)
   if(this->servoIndex < MAX_SERVOS ) {
     pinMode( pin, OUTPUT) ;                                   // set servo pin to output
     servos[this->servoIndex].Pin.nbr = pin;
+    servos[this->servoIndex].outReg = portOutputRegister(digitalPinToPort(pin));
+    servos[this->servoIndex].bitMask = digitalPinToBitMask(pin);
     // todo min/max check: abs(min - MIN_PULSE_WIDTH) /4 < 128
     this->min  = (MIN_PULSE_WIDTH - min)/4; //resolution of min/max is 4 uS
     this->max  = (MAX_PULSE_WIDTH - max)/4;
     // initialize the timer if it has not already been initialized
     timer16_Sequence_t timer = SERVO_INDEX_TO_TIMER(servoIndex);
+    updateRefresh(timer);
     if(isTimerActive(timer) == false)
       initISR(timer);
     servos[this->servoIndex].Pin.isActive = true;  // this must be set after the check for isTimerActive
@@ -275,22 +419,67 @@ void Servo::write(int value)
 void Servo::writeMicroseconds(int value)
 {
   // calculate and store the values for the given channel
+  this->writeTicks(this->microsecondsToTicks(value));
+}
+
+unsigned int Servo::microsecondsToTicks(int value)
+{
+  if( value < SERVO_MIN() )          // ensure pulse width is valid
+    value = SERVO_MIN();
+  else if( value > SERVO_MAX() )
+    value = SERVO_MAX();
+
+  value = value - TRIM_DURATION;
+  return usToTicks(value);  // convert to ticks after compensating for interrupt overhead - 12 Aug 2009
+}
+
+void Servo::writeTicks(unsigned int ticks)
+{
+  this->writeTicks(ticks, 0);
+}
+
+void Servo::writeTicks(unsigned int ticks, unsigned int rate)
+{
   byte channel = this->servoIndex;
   if( (channel < MAX_SERVOS) )   // ensure channel is valid
   {
-    if( value < SERVO_MIN() )          // ensure pulse width is valid
-      value = SERVO_MIN();
-    else if( value > SERVO_MAX() )
-      value = SERVO_MAX();
-
-    value = value - TRIM_DURATION;
-    value = usToTicks(value);  // convert to ticks after compensating for interrupt overhead - 12 Aug 2009
+    uint8_t oldSREG = SREG;
+    cli();
+    if( rate == 0 )
+      servos[channel].ticks = ticks;   // jump straight there
+    servos[channel].target = ticks;
+    servos[channel].rate = rate;
+    servos[channel].frac = 0;
+    SREG = oldSREG;
+  }
+}
 
+unsigned int Servo::readTicks()
+{
+  unsigned int ticks = 0;
+  if( this->servoIndex != INVALID_SERVO ) {
     uint8_t oldSREG = SREG;
     cli();
-    servos[channel].ticks = value;
+    ticks = servos[this->servoIndex].ticks;
     SREG = oldSREG;
   }
+  return ticks;
+}
+
+bool Servo::isMoving()
+{
+  return this->servoIndex != INVALID_SERVO && this->readTicks() != servos[this->servoIndex].target;
+}
+
+unsigned int Servo::ticksRate(unsigned int usPerSecond)
+{
+  // ticks per second times the refresh interval in seconds, in 1/256 ticks
+  unsigned long rate = ((unsigned long)usToTicks((unsigned long)usPerSecond) * this->refreshInterval()) / (1000000UL / 256);
+  if( rate > 0xffff )
+    rate = 0xffff;
+  else if( rate == 0 && usPerSecond > 0 )
+    rate = 1;                        // slowest there is, 0 would jump
+  return rate;
 }
 
 int Servo::read() // return the value as degrees
@@ -302,7 +491,7 @@ int Servo::readMicroseconds()
 {
   unsigned int pulsewidth;
   if( this->servoIndex != INVALID_SERVO )
-    pulsewidth = ticksToUs(servos[this->servoIndex].ticks)  + TRIM_DURATION ;   // 12 aug 2009
+    pulsewidth = ticksToUs(this->readTicks())  + TRIM_DURATION ;   // 12 aug 2009
   else
     pulsewidth  = 0;
 
@@ -314,5 +503,29 @@ bool Servo::attached()
   return servos[this->servoIndex].Pin.isActive ;
 }
 
+unsigned int Servo::setRefreshInterval(unsigned int us)
+{
+  if( this->servoIndex == INVALID_SERVO )
+    return 0;
+  timer16_Sequence_t timer = SERVO_INDEX_TO_TIMER(servoIndex);
+  refreshRequest[timer] = us;
+  updateRefresh(timer);
+  return this->refreshInterval();
+}
+
+unsigned int Servo::refreshInterval()
+{
+  if( this->servoIndex == INVALID_SERVO )
+    return 0;
+  timer16_Sequence_t timer = SERVO_INDEX_TO_TIMER(servoIndex);
+  uint8_t oldSREG = SREG;
+  cli();
+  unsigned int ticks = refreshTicks[timer];
+  SREG = oldSREG;
+  if( ticks == 0 )  // not attached yet
+    return REFRESH_INTERVAL;
+  return ((unsigned long)ticks * 8) / clockCyclesPerMicrosecond();  // ticksToUs() would overflow
+}
+
 #endif // ARDUINO_ARCH_AVR
 
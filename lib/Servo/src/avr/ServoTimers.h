@@ -31,7 +31,13 @@
  */
 
 // Say which 16 bit timers can be used and in what order
-#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+// Define SERVO_USE_TIMER2 to drive the servos from 8 bit Timer2 instead, extended to 16 bits
+// in software, leaving all the 16 bit timers free for other uses (tone() uses Timer2 too).
+#if defined(SERVO_USE_TIMER2)
+#define _useTimer2
+typedef enum { _timer2, _Nbr_16timers } timer16_Sequence_t;
+
+#elif defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
 #define _useTimer5
 #define _useTimer1
 #define _useTimer3
@@ -0,0 +1,57 @@
+#include <Endstop.h>
+#include <util/atomic.h>
+
+// the Endstop using the PCINT0 interrupt
+static Endstop* pcint0Endstop = nullptr;
+
+ISR(PCINT0_vect) {
+  if (pcint0Endstop) pcint0Endstop->handleChange();
+}
+
+bool Endstop::begin(uint8_t pin) {
+  if (digitalPinToPCICR(pin) != &PCICR || digitalPinToPCICRbit(pin) != PCIE0)
+    return false;
+
+  pinMode(pin, INPUT_PULLUP);
+  inputRegister = portInputRegister(digitalPinToPort(pin));
+  bitMask = digitalPinToBitMask(pin);
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    pcint0Endstop = this;
+    *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+    PCIFR = _BV(PCIF0);
+    PCICR |= _BV(PCIE0);
+  }
+  return true;
+}
+
+void Endstop::arm() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    armTime = micros();
+    hitTime = armTime;
+    hit = isPressed();
+    armed = !hit;
+  }
+}
+
+unsigned long Endstop::armedAt() const {
+  unsigned long time;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { time = armTime; }
+  return time;
+}
+
+unsigned long Endstop::triggeredAt() const {
+  unsigned long time;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { time = hitTime; }
+  return time;
+}
+
+// any change on port B lands here, so check it is our pin going low; later
+// bounces are ignored until the next arm()
+void Endstop::handleChange() {
+  if (!armed || (*inputRegister & bitMask)) return;
+
+  hitTime = micros();
+  hit = true;
+  armed = false;
+}
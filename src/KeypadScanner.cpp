@@ -0,0 +1,99 @@
+#include <KeypadScanner.h>
+#include <util/atomic.h>
+
+// the KeypadScanner using the Timer0 compare A interrupt
+static KeypadScanner* timer0Scanner = nullptr;
+
+ISR(TIMER0_COMPA_vect) {
+  if (timer0Scanner) timer0Scanner->scan();
+}
+
+KeypadScanner::KeypadScanner(const char (*keymap)[cols],
+                             const uint8_t* rowPins, const uint8_t* colPins)
+    : keymap(keymap), rowPins(rowPins), colPins(colPins) {}
+
+void KeypadScanner::begin() {
+  for (uint8_t r = 0; r < rows; r++) {
+    pinMode(rowPins[r], INPUT_PULLUP);
+    rowInput[r] = portInputRegister(digitalPinToPort(rowPins[r]));
+    rowMask[r] = digitalPinToBitMask(rowPins[r]);
+  }
+  // idle columns float on their pull ups so two pressed keys in a row
+  // never short a high output to a low one
+  for (uint8_t c = 0; c < cols; c++) {
+    pinMode(colPins[c], INPUT_PULLUP);
+    colOutput[c] = portOutputRegister(digitalPinToPort(colPins[c]));
+    colMode[c] = portModeRegister(digitalPinToPort(colPins[c]));
+    colMask[c] = digitalPinToBitMask(colPins[c]);
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    column = 0;
+    *colOutput[column] &= ~colMask[column];
+    *colMode[column] |= colMask[column];
+
+    timer0Scanner = this;
+    OCR0A = 0x80;  // half way between millis() overflows
+    TIFR0 = _BV(OCF0A);
+    TIMSK0 |= _BV(OCIE0A);
+  }
+}
+
+bool KeypadScanner::getEvent(Event* event) {
+  uint8_t t = tail;
+  if (t == head) return false;
+
+  uint8_t queued = events[t];
+  uint8_t key = queued & ~releasedFlag;
+  event->key = keymap[key / cols][key % cols];
+  event->pressed = !(queued & releasedFlag);
+  tail = (t + 1) % queueLength;
+  return true;
+}
+
+char KeypadScanner::getKey() {
+  Event event;
+  while (getEvent(&event)) {
+    if (event.pressed) return event.key;
+  }
+  return NO_KEY;
+}
+
+void KeypadScanner::scan() {
+  for (uint8_t r = 0; r < rows; r++) {
+    uint8_t key = r * cols + column;
+    uint16_t bit = 1 << key;
+    uint8_t& count = counts[key];
+
+    // integrate: count towards debounceSamples while down, towards 0 while up
+    if (!(*rowInput[r] & rowMask[r])) {
+      if (count < debounceSamples) count++;
+    } else if (count > 0) {
+      count--;
+    }
+
+    if (count == debounceSamples && !(held & bit)) {
+      held |= bit;
+      push(key);
+    } else if (count == 0 && (held & bit)) {
+      held &= ~bit;
+      push(key | releasedFlag);
+    }
+  }
+
+  // let this column go back to its pull up and pull the next one low, to be
+  // read on the next tick once it has settled
+  *colMode[column] &= ~colMask[column];
+  *colOutput[column] |= colMask[column];
+  column = (column + 1) % cols;
+  *colOutput[column] &= ~colMask[column];
+  *colMode[column] |= colMask[column];
+}
+
+// a full queue drops the new event rather than overwrite one not yet read
+void KeypadScanner::push(uint8_t event) {
+  uint8_t next = (head + 1) % queueLength;
+  if (next == tail) return;
+  events[head] = event;
+  head = next;
+}
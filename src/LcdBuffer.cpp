@@ -0,0 +1,40 @@
+#include <LcdBuffer.h>
+
+LcdBuffer::LcdBuffer(LiquidCrystal* lcd) : lcd(lcd) { clear(); }
+
+void LcdBuffer::clear() {
+  memset(text, ' ', sizeof(text));
+  col = 0;
+  row = 0;
+}
+
+void LcdBuffer::setCursor(uint8_t col, uint8_t row) {
+  this->col = col;
+  this->row = row < rows ? row : rows - 1;
+}
+
+size_t LcdBuffer::write(uint8_t c) {
+  if (col >= cols) return 0;
+  text[row][col++] = c;
+  return 1;
+}
+
+void LcdBuffer::flush() {
+  for (uint8_t r = 0; r < rows; r++) {
+    uint8_t c = 0;
+    while (c < cols) {
+      if (!stale && text[r][c] == shown[r][c]) {
+        c++;
+        continue;
+      }
+      // one setCursor() for the whole run of changed cells
+      lcd->setCursor(c, r);
+      do {
+        lcd->write(text[r][c]);
+        shown[r][c] = text[r][c];
+        c++;
+      } while (c < cols && (stale || text[r][c] != shown[r][c]));
+    }
+  }
+  stale = false;
+}
@@ -0,0 +1,60 @@
+#include <NumberFormat.h>
+
+static const uint16_t powersOfTen16[] PROGMEM = {10000, 1000, 100, 10, 1};
+static const uint32_t powersOfTen32[] PROGMEM = {
+    1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1};
+
+static inline uint16_t readPower(const uint16_t* power) {
+  return pgm_read_word(power);
+}
+static inline uint32_t readPower(const uint32_t* power) {
+  return pgm_read_dword(power);
+}
+
+template <typename T, uint8_t N>
+static uint8_t countDigits(T value, const T (&powers)[N]) {
+  uint8_t digits = N;
+  while (digits > 1 && value < readPower(&powers[N - digits])) digits--;
+  return digits;
+}
+
+// each digit is how many times its power of ten can be taken away, which is
+// cheaper than dividing on the AVR
+template <typename T, uint8_t N>
+static size_t printDigits(Print& out, T value, const T (&powers)[N],
+                          uint8_t width, char pad) {
+  uint8_t digits = countDigits(value, powers);
+  if (!width) width = digits;
+
+  if (digits > width) {
+    for (uint8_t i = 0; i < width; i++) out.write('#');
+    return width;
+  }
+  for (uint8_t i = digits; i < width; i++) out.write(pad);
+  for (uint8_t i = N - digits; i < N; i++) {
+    T power = readPower(&powers[i]);
+    char digit = '0';
+    while (value >= power) {
+      value -= power;
+      digit++;
+    }
+    out.write(digit);
+  }
+  return width;
+}
+
+uint8_t decimalDigits(uint16_t value) {
+  return countDigits(value, powersOfTen16);
+}
+
+uint8_t decimalDigits(uint32_t value) {
+  return countDigits(value, powersOfTen32);
+}
+
+size_t printFixed(Print& out, uint16_t value, uint8_t width, char pad) {
+  return printDigits(out, value, powersOfTen16, width, pad);
+}
+
+size_t printFixed(Print& out, uint32_t value, uint8_t width, char pad) {
+  return printDigits(out, value, powersOfTen32, width, pad);
+}
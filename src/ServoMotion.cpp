@@ -0,0 +1,53 @@
+#include <ServoMotion.h>
+
+ServoMotion::ServoMotion(Servo* servo) : servo(servo) {}
+
+void ServoMotion::begin(uint16_t pulseUs) {
+  count = 0;
+  phaseStarted = false;
+  servo->writeMicroseconds(pulseUs);
+}
+
+bool ServoMotion::addPhase(uint16_t targetUs, uint16_t speed) {
+  if (count >= maxPhases) return false;
+
+  Phase& phase = phases[(head + count) % maxPhases];
+  phase.target = targetUs;
+  phase.speed = speed;
+  count++;
+  return true;
+}
+
+void ServoMotion::clear() {
+  if (count > 1) count = 1;
+  if (!phaseStarted) count = 0;
+}
+
+void ServoMotion::stop() {
+  count = 0;
+  phaseStarted = false;
+  servo->writeTicks(servo->readTicks());  // the ISR stops where it got to
+}
+
+uint16_t ServoMotion::position() const { return servo->readMicroseconds(); }
+
+// hands the phase to the servo ISR, which moves the pulse width each frame
+void ServoMotion::startPhase() {
+  const Phase& phase = phases[head];
+  servo->writeTicks(servo->microsecondsToTicks(phase.target),
+                    phase.speed ? servo->ticksRate(phase.speed) : 0);
+  phaseStarted = true;
+}
+
+bool ServoMotion::update() {
+  while (count > 0) {
+    if (!phaseStarted) startPhase();
+    if (servo->isMoving()) return true;
+
+    // phase done, go straight on to the next one
+    head = (head + 1) % maxPhases;
+    count--;
+    phaseStarted = false;
+  }
+  return false;
+}
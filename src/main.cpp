@@ -1,9 +1,16 @@
 #include <AccelStepper.h>
+#include <AccelStepperQueue.h>
+#include <AccelStepperRamp.h>
+#include <AccelStepperT.h>
 #include <Arduino.h>
 #include <EEPROM.h>
-#include <Keypad.h>
+#include <Endstop.h>
+#include <KeypadScanner.h>
+#include <LcdBuffer.h>
 #include <LiquidCrystal.h>
+#include <NumberFormat.h>
 #include <Servo.h>
+#include <ServoMotion.h>
 
 #define VERSION "V0.4"
 #define DEBUG
@@ -38,27 +45,71 @@ struct stripJob {
   uint16_t strips = 0;
   uint16_t length = 0;
 };
+const uint16_t maxStrips = 255;
+const uint16_t maxLength = 10000;  // mm
 
 const uint8_t servoPin = 12;
 const uint8_t servoEndstop = 13;
+Endstop endstop;
+
+// longest a cut may take from the start of the stroke to the endstop
+const unsigned long cutTimeoutMs = 4000;
 
 const uint8_t rs = PIN_A5, en = PIN_A4, d4 = PIN_A3, d5 = PIN_A2, d6 = PIN_A1,
               d7 = PIN_A0;
 LiquidCrystal lcd(rs, en, d4, d5, d6, d7);
+LcdBuffer screen(&lcd);  // for screens redrawn while running a job
+
+KeypadScanner keypad(KPKeys, rowPins, colPins);
 
-Keypad keypad = Keypad(makeKeymap(KPKeys), rowPins, colPins, ROWS, COLS);
+AccelStepperT<AccelStepper::DRIVER, 2, 3> stepper;  // step, dir
 
-AccelStepper stepper(AccelStepper::DRIVER, 2, 3);  // step, dir
+// steps/s^2 and steps/s, fixed at build time so the ramp can live in flash
+const uint16_t feedAcceleration = 100;
+const uint16_t feedMaxSpeed = 500;
+typedef AccelStepperRamp<feedAcceleration, feedMaxSpeed> FeedRamp;
+
+AccelStepperQueue feedQueue(stepper);
 
 Servo servo;
+ServoMotion cutter(&servo);
+const uint16_t servoRefreshUs = 3333;  // 300 Hz, the cutter is a digital servo
+
+// cut stroke as servo pulse widths (us) and speeds (us of pulse width per s)
+const uint16_t cutRestUs = MIN_PULSE_WIDTH;  // 0 degrees
+const uint16_t cutApproachUs = 1200;  // blade just above the webbing, until learned
+const uint16_t cutEndUs = MAX_PULSE_WIDTH;   // 180 degrees, if the endstop never trips
+const uint16_t cutArcUs = 400;  // pass before the trip point, covers the webbing
+const uint16_t cutApproachSpeed = 4000;
+const uint16_t cutPassSpeed = 690;   // the old sweep of 1 degree per 15 ms
+const uint16_t cutReturnSpeed = 4000;  // about what the servo manages
+
+// the stroke stops at the endstop; where that happens is learned so the blade
+// can park cutArcUs short of it, just clear of the webbing
+uint16_t tripUs = 0;  // 0 until the first cut
+uint16_t parkUs = cutRestUs;
+
+// when the next strip may start feeding after a cut
+enum bladeClear : uint8_t {
+  clearAfterSettle,  // blade back at park, then 500 ms to settle
+  clearAtEndstop,    // straight away, once the blade reaches the endstop
+  clearAtPark        // as soon as the return stroke gets back to park
+};
+const bladeClear feedStartsWhen = clearAtPark;
 
-uint8_t intDigits(uint16_t n);
 uint16_t getInput(LiquidCrystal* lcd, const uint8_t lcdRow,
                   const uint8_t lcdCol, uint16_t prevInput,
                   const uint16_t maxInput);
-void servoCut(Servo* servo);
-void runJob(LiquidCrystal* lcd, AccelStepper* stepper, Servo* servo,
-            stripJob job);
+enum cutResult : uint8_t { cutRunning, cutFinished, cutJammed };
+
+void startCut(ServoMotion* cutter, Endstop* endstop);
+cutResult cutStatus(ServoMotion* cutter, Endstop* endstop);
+void learnTrip(uint16_t pulseUs);
+bool bladeIsClear(ServoMotion* cutter);
+bool runJob(LcdBuffer* screen, AccelStepperQueue* feed, ServoMotion* cutter,
+            Endstop* endstop, stripJob job);
+void reportJam(LcdBuffer* screen, stripJob job, uint16_t strip);
+void printStrip(LcdBuffer* screen, stripJob job, uint16_t strip);
 uint16_t mmToSteps(uint16_t millimeters);
 uint8_t setJob(LiquidCrystal* lcd, stripJob* job);
 void printJob(LiquidCrystal* lcd, stripJob job);
@@ -68,10 +119,11 @@ void setup() {
 
   lcd.begin(16, 2);
 
-  pinMode(servoEndstop, INPUT_PULLUP);
+  endstop.begin(servoEndstop);
 
   servo.attach(servoPin);
-  servo.write(0);
+  servo.setRefreshInterval(servoRefreshUs);
+  cutter.begin(cutRestUs);
 
   // first time setup
   uint16_t magic_0_4 = 48343;
@@ -87,11 +139,14 @@ void setup() {
   }
 
   // 2500
-  stepper.setMaxSpeed(500);
-  stepper.setSpeed(500);
-  stepper.setAcceleration(100.0);
+  stepper.setMaxSpeed(feedMaxSpeed);
+  stepper.setSpeed(feedMaxSpeed);
+  stepper.setAcceleration(feedAcceleration);
+  stepper.setRampTable(FeedRamp::table, FeedRamp::length);
+  stepper.attachTimer();
+  stepper.setTimerPulse();
 
-  keypad.setDebounceTime(100);
+  keypad.begin();
 
   lcd.print("WCUT ");
   lcd.print(VERSION);
@@ -176,9 +231,13 @@ void loop() {
     }
   }
 
-  for (uint8_t i = 0; i < totalJobs; i++) {
-    runJob(&lcd, &stepper, &servo, jobs[i]);
+  // the job screens are sent a nibble at a time between steps
+  lcd.setQueued();
+  bool completed = true;
+  for (uint8_t i = 0; i < totalJobs && completed; i++) {
+    completed = runJob(&screen, &feedQueue, &cutter, &endstop, jobs[i]);
   }
+  lcd.setQueued(false);
 
   EEPROM.put(10, jobs[0]);
   EEPROM.put(20, jobs[1]);
@@ -187,8 +246,9 @@ void loop() {
 
   selectedJob = 0;
   lcd.clear();
-  lcd.print("Done.");
+  lcd.print(completed ? "Done." : "Stopped.");
   delay(2000);
+  keypad.clear();  // keys pressed during the jobs are not for the menus
 }
 
 uint16_t getInput(LiquidCrystal* lcd, const uint8_t lcdRow,
@@ -196,10 +256,12 @@ uint16_t getInput(LiquidCrystal* lcd, const uint8_t lcdRow,
                   const uint16_t maxInput) {
   char key = keypad.getKey();
   uint16_t input = prevInput;
-  uint8_t charsPrinted = intDigits(input);
+  // right aligned in a field wide enough for maxInput, so every change just
+  // overwrites it
+  const uint8_t width = decimalDigits(maxInput);
 
   lcd->setCursor(lcdRow, lcdCol);
-  lcd->print(input);
+  printFixed(*lcd, input, width);
 
   while (key != '#') {
     switch (key) {
@@ -229,14 +291,9 @@ uint16_t getInput(LiquidCrystal* lcd, const uint8_t lcdRow,
       case '9':
         if (!(input * 10 + (key - '0') > maxInput) &&
             (input * 10 + (key - '0') != 0)) {
-          if (input == 0) {
-            lcd->setCursor(lcdRow, lcdCol);
-            lcd->print(' ');
-            lcd->setCursor(lcdRow, lcdCol);
-          }
           input = input * 10 + (key - '0');
-          lcd->print(key);
-          charsPrinted++;
+          lcd->setCursor(lcdRow, lcdCol);
+          printFixed(*lcd, input, width);
           DEBUG_PRINTLN("input: ");
           DEBUG_PRINTLN(input);
         }
@@ -246,13 +303,8 @@ uint16_t getInput(LiquidCrystal* lcd, const uint8_t lcdRow,
           return 0xffff;
         else {
           input = 0;
-          for (uint8_t i = 0; i < charsPrinted; i++) {
-            lcd->setCursor(lcdRow + i, lcdCol);
-            lcd->print(' ');
-          }
           lcd->setCursor(lcdRow, lcdCol);
-          lcd->print(input);
-          charsPrinted = 1;
+          printFixed(*lcd, input, width);
           DEBUG_PRINTLN("");
         }
         break;
@@ -268,47 +320,172 @@ uint16_t getInput(LiquidCrystal* lcd, const uint8_t lcdRow,
   return input;
 }
 
-void servoCut(Servo* servo) {
-  for (uint8_t pos = 0; pos <= 180; pos++) {
-    servo->write(pos);
-    delay(15);
-  }
+// fast approach to just short of the webbing, then pass through it at cutting
+// speed towards the end of travel
+void startCut(ServoMotion* cutter, Endstop* endstop) {
+  const uint16_t approachUs = tripUs ? parkUs : cutApproachUs;
 
-  while (digitalRead(servoEndstop)) {
+  endstop->arm();
+  if (cutter->position() < approachUs)
+    cutter->addPhase(approachUs, cutApproachSpeed);
+  cutter->addPhase(cutEndUs, cutPassSpeed);
+}
+
+// finished as soon as the blade trips the endstop, which stops the stroke
+// and sends the blade back to park; jammed if that takes too long
+cutResult cutStatus(ServoMotion* cutter, Endstop* endstop) {
+  if (!endstop->triggered()) {
+    if ((micros() - endstop->armedAt()) / 1000 > cutTimeoutMs) {
+      endstop->disarm();
+      return cutJammed;
+    }
+    return cutRunning;
   }
-  servo->write(0);
+
+  cutter->stop();
+  // a switch already closed when armed says nothing new about where it trips
+  if (endstop->triggeredAt() != endstop->armedAt())
+    learnTrip(cutter->position());
+  cutter->addPhase(parkUs, cutReturnSpeed);
+
+  DEBUG_PRINT("cut ms: ");
+  DEBUG_PRINT((endstop->triggeredAt() - endstop->armedAt()) / 1000);
+  DEBUG_PRINT(" trip us: ");
+  DEBUG_PRINTLN(tripUs);
+  return cutFinished;
 }
 
-void runJob(LiquidCrystal* lcd, AccelStepper* stepper, Servo* servo,
-            stripJob job) {
-  if (!job.strips || !job.length) return;
+// running average of where the endstop trips, with park cutArcUs before it
+void learnTrip(uint16_t pulseUs) {
+  tripUs = tripUs ? (3 * (uint32_t)tripUs + pulseUs) / 4 : pulseUs;
+  parkUs = tripUs > cutRestUs + cutArcUs ? tripUs - cutArcUs : cutRestUs;
+}
 
-  for (uint8_t i = 0; i < job.strips; i++) {
-    lcd->clear();
-    lcd->setCursor(15, 0);
-    lcd->print(job.id);
+bool bladeIsClear(ServoMotion* cutter) {
+  switch (feedStartsWhen) {
+    case clearAfterSettle:
+      return !cutter->isMoving();
+    case clearAtEndstop:
+      return true;
+    case clearAtPark:
+      return cutter->position() <= parkUs;
+  }
+  return true;
+}
 
-    lcd->setCursor(0, 0);
-    lcd->print(job.length);
-    lcd->print("mm");
+// returns false if the job was stopped by a cutter jam
+bool runJob(LcdBuffer* screen, AccelStepperQueue* feed, ServoMotion* cutter,
+            Endstop* endstop, stripJob job) {
+  if (!job.strips || !job.length) return true;
+
+  const uint16_t feedSteps = mmToSteps(job.length);
+  // feed, hold for the cut, and settle unless the feed overlaps the return
+  const uint8_t segmentsPerStrip = feedStartsWhen == clearAfterSettle ? 3 : 2;
+  uint16_t queued = 0;
+  uint16_t cut = 0;
+  enum : uint8_t { waiting, cutting, returning } cutStage = waiting;
+
+  screen->invalidate();  // the menus wrote to the LCD directly
+  printStrip(screen, job, 1);
+
+  // keep the queue topped up so the next feed starts as soon as the blade
+  // is clear, while the cutter is still on its way back
+  while (cut < job.strips) {
+    while (queued < job.strips && feed->available() >= segmentsPerStrip) {
+      feed->move(feedSteps);
+      feed->hold();
+      if (feedStartsWhen == clearAfterSettle) feed->dwell(500);
+      queued++;
+    }
 
-    lcd->setCursor(0, 1);
-    lcd->print(i + 1);
-    lcd->print('/');
-    lcd->print(job.strips);
+    feed->run();
+    cutter->update();
+    screen->poll();
 
-    stepper->move(mmToSteps(job.length));
+    if (!feed->isHeld()) continue;
 
-    while (stepper->distanceToGo() != 0) {
-      stepper->run();
+    switch (cutStage) {
+      case waiting:
+        startCut(cutter, endstop);
+        cutStage = cutting;
+        break;
+      case cutting:
+        switch (cutStatus(cutter, endstop)) {
+          case cutRunning:
+            break;
+          case cutFinished:
+            cutStage = returning;
+            break;
+          case cutJammed:
+            // pull the blade back and drop the rest of the job
+            cutter->stop();
+            cutter->addPhase(cutRestUs, cutReturnSpeed);
+            feed->clear();
+            feed->release();
+            while (feed->run() | cutter->update()) {
+              screen->poll();
+            }
+            reportJam(screen, job, cut + 1);
+            return false;
+        }
+        break;
+      case returning:
+        if (bladeIsClear(cutter)) {
+          cutStage = waiting;
+          cut++;
+          if (cut < job.strips) printStrip(screen, job, cut + 1);
+          feed->release();
+        }
+        break;
     }
+  }
 
-    servoCut(servo);
+  // the last settle time and return stroke
+  while (feed->run() | cutter->update()) {
+    screen->poll();
+  }
+  return true;
+}
 
-    delay(500);
+void reportJam(LcdBuffer* screen, stripJob job, uint16_t strip) {
+  DEBUG_PRINTLN("cutter jam");
+  keypad.clear();  // keys pressed during the job must not dismiss it
+  screen->clear();
+  screen->print("Cutter jam");
+  screen->setCursor(15, 0);
+  screen->print(job.id);
+
+  screen->setCursor(0, 1);
+  printFixed(*screen, strip, decimalDigits(job.strips));
+  screen->print('/');
+  printFixed(*screen, job.strips);
+  screen->print(" any key");
+  screen->flush();
+
+  while (keypad.getKey() == NO_KEY) {
+    screen->poll();
   }
 }
 
+// only the cells that changed since the last strip reach the LCD, usually
+// just the counter
+void printStrip(LcdBuffer* screen, stripJob job, uint16_t strip) {
+  screen->clear();
+  screen->setCursor(15, 0);
+  screen->print(job.id);
+
+  screen->setCursor(0, 0);
+  printFixed(*screen, job.length);
+  screen->print("mm");
+
+  // the counter keeps its width, so only its changed digits are sent
+  screen->setCursor(0, 1);
+  printFixed(*screen, strip, decimalDigits(job.strips));
+  screen->print('/');
+  printFixed(*screen, job.strips);
+  screen->flush();
+}
+
 uint16_t mmToSteps(uint16_t millimeters) {
   const uint16_t gearDiameterMM = 50;
   const uint8_t motorStepsPerRevolution = 200;
@@ -318,15 +495,6 @@ uint16_t mmToSteps(uint16_t millimeters) {
   return stepsPerMM * millimeters;
 }
 
-uint8_t intDigits(uint16_t n) {
-  //  if (n == 0) return 0;
-  if (n < 10) return 1;
-  if (n < 100) return 2;
-  if (n < 1000) return 3;
-  if (n < 10000) return 4;
-  if (n < 100000) return 5;
-}
-
 uint8_t setJob(LiquidCrystal* lcd, stripJob* job) {
   lcd->clear();
 
@@ -342,12 +510,12 @@ uint8_t setJob(LiquidCrystal* lcd, stripJob* job) {
   lcd->print("Length:");
   if (job->strips != 0 && job->length != 0) {
     lcd->setCursor(7, 0);
-    lcd->print(job->strips);
+    printFixed(*lcd, job->strips, decimalDigits(maxStrips));
     lcd->setCursor(7, 1);
-    lcd->print(job->length);
+    printFixed(*lcd, job->length, decimalDigits(maxLength));
   }
 
-  uint16_t strips = getInput(lcd, 7, 0, job->strips, 255);
+  uint16_t strips = getInput(lcd, 7, 0, job->strips, maxStrips);
   if (strips >= 0x7fff) {
     switch (strips) {
       case 0x7fff:
@@ -370,9 +538,9 @@ uint8_t setJob(LiquidCrystal* lcd, stripJob* job) {
   }
   job->strips = strips;
   lcd->setCursor(7, 0);
-  lcd->print(job->strips);
+  printFixed(*lcd, job->strips, decimalDigits(maxStrips));
 
-  uint16_t length = getInput(lcd, 7, 1, job->length, 10000);
+  uint16_t length = getInput(lcd, 7, 1, job->length, maxLength);
   if (length >= 0x7fff) {
     switch (length) {
       case 0x7fff:
@@ -395,7 +563,7 @@ uint8_t setJob(LiquidCrystal* lcd, stripJob* job) {
   }
   job->length = length;
   lcd->setCursor(7, 1);
-  lcd->print(job->length);
+  printFixed(*lcd, job->length, decimalDigits(maxLength));
 
   // lcd.noCursor();
   lcd->noBlink();
@@ -406,8 +574,8 @@ uint8_t setJob(LiquidCrystal* lcd, stripJob* job) {
 void printJob(LiquidCrystal* lcd, stripJob job) {
   lcd->print(job.id);
   lcd->print(": ");
-  lcd->print(job.strips);
+  printFixed(*lcd, job.strips);
   lcd->print('x');
-  lcd->print(job.length);
+  printFixed(*lcd, job.length);
   lcd->print("mm");
 }
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Just enough of the Arduino core for the native tests to build the libraries
+// on the host. The tests own the clock: micros() returns fakeMicros.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+
+#define constrain(amt, low, high) \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+template <class T, class U>
+static inline auto max(T a, U b) -> decltype(a + b) {
+  return a > b ? a : b;
+}
+template <class T, class U>
+static inline auto min(T a, U b) -> decltype(a + b) {
+  return a < b ? a : b;
+}
+
+static inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+extern unsigned long fakeMicros;
+
+static inline unsigned long micros() { return fakeMicros; }
+static inline unsigned long millis() { return fakeMicros / 1000; }
+static inline void delay(unsigned long) {}
+static inline void delayMicroseconds(unsigned int) {}
+static inline void pinMode(uint8_t, uint8_t) {}
+static inline void digitalWrite(uint8_t, uint8_t) {}
+static inline int digitalRead(uint8_t) { return LOW; }
+static inline void yield() {}
+
+#endif  // ARDUINO_H
@@ -0,0 +1,20 @@
+#ifndef PRINT_H
+#define PRINT_H
+
+// Just enough of Print for LiquidCrystal.h to build on the host
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+};
+
+#endif  // PRINT_H
@@ -0,0 +1,19 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+// Wire that goes nowhere. The tests capture the bytes before they reach it.
+
+#include <stddef.h>
+#include <stdint.h>
+
+class TwoWire {
+ public:
+  void begin() {}
+  void beginTransmission(uint8_t) {}
+  size_t write(const uint8_t*, size_t count) { return count; }
+  uint8_t endTransmission() { return 0; }
+};
+
+static TwoWire Wire;
+
+#endif  // WIRE_H
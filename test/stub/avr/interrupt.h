@@ -0,0 +1,11 @@
+#ifndef AVR_INTERRUPT_H
+#define AVR_INTERRUPT_H
+
+// Interrupt handlers become plain functions the native tests call themselves
+
+#define ISR(vector) extern "C" void vector(void)
+#define SIGNAL(vector) ISR(vector)
+#define cli()
+#define sei()
+
+#endif  // AVR_INTERRUPT_H
@@ -0,0 +1,2 @@
+// The PCF8574 backpack transport, with Wire from test/stub
+#include "../../lib/LiquidCrystalPCF8574/src/LiquidCrystalPCF8574.cpp"
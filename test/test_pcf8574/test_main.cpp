@@ -0,0 +1,169 @@
+#include <unity.h>
+
+#include <Arduino.h>
+#include <LiquidCrystalPCF8574.h>
+
+unsigned long fakeMicros;
+
+// Keeps every byte the transport would have written to the expander, and
+// where each I2C transfer ended
+class RecordingPCF8574 : public LiquidCrystalPCF8574 {
+ public:
+  uint8_t bytes[256];
+  int count;
+  int transfers;
+  int transferEnd[64];
+
+  RecordingPCF8574() { clear(); }
+
+  void clear() {
+    count = 0;
+    transfers = 0;
+  }
+
+ protected:
+  virtual void transmit(const uint8_t* data, uint8_t n) {
+    TEST_ASSERT_TRUE(n <= PCF8574_LCD_TRANSFER);
+    while (n--) bytes[count++] = *data++;
+    transferEnd[transfers++] = count;
+  }
+};
+
+// Rebuilds what the LCD latches: the data nibble on each falling enable edge,
+// with RS as it was on that edge. Fails if RS or the backlight change while
+// enable is high, or if a transfer ends with enable high.
+static int latchedNibbles(const RecordingPCF8574& lcd, uint8_t* nibbles,
+                          uint8_t* rs, uint8_t backlight) {
+  int n = 0;
+  int transfer = 0;
+  uint8_t last = backlight;  // begin() leaves everything else low
+  for (int i = 0; i < lcd.count; i++) {
+    uint8_t b = lcd.bytes[i];
+    TEST_ASSERT_EQUAL_HEX8(backlight, b & PCF8574_LCD_BACKLIGHT);
+    TEST_ASSERT_EQUAL_HEX8(0, b & PCF8574_LCD_RW);
+    if (last & PCF8574_LCD_ENABLE) {
+      TEST_ASSERT_EQUAL_HEX8(last & PCF8574_LCD_RS, b & PCF8574_LCD_RS);
+      TEST_ASSERT_EQUAL_HEX8(last & 0xf0, b & 0xf0);
+      if (!(b & PCF8574_LCD_ENABLE)) {
+        nibbles[n] = b >> 4;
+        rs[n] = b & PCF8574_LCD_RS;
+        n++;
+      }
+    }
+    last = b;
+    if (i + 1 == lcd.transferEnd[transfer]) {
+      TEST_ASSERT_EQUAL_HEX8(0, b & PCF8574_LCD_ENABLE);
+      transfer++;
+    }
+  }
+  return n;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_write4bits() {
+  RecordingPCF8574 lcd;
+  lcd.begin();
+  TEST_ASSERT_EQUAL(1, lcd.count);
+  TEST_ASSERT_EQUAL_HEX8(PCF8574_LCD_BACKLIGHT, lcd.bytes[0]);
+
+  lcd.clear();
+  lcd.write4bits(0x3);
+  uint8_t expected[] = {
+      PCF8574_LCD_BACKLIGHT,
+      0x30 | PCF8574_LCD_BACKLIGHT | PCF8574_LCD_ENABLE,
+      0x30 | PCF8574_LCD_BACKLIGHT,
+  };
+  TEST_ASSERT_EQUAL(1, lcd.transfers);
+  TEST_ASSERT_EQUAL(sizeof(expected), lcd.count);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, lcd.bytes, sizeof(expected));
+}
+
+// High nibble first, RS set for data and clear for commands, backlight kept
+void test_packing() {
+  RecordingPCF8574 lcd;
+  lcd.begin();
+
+  for (int mode = LOW; mode <= HIGH; mode++) {
+    for (int backlight = 0; backlight < 2; backlight++) {
+      if (backlight)
+        lcd.backlight();
+      else
+        lcd.noBacklight();
+      lcd.clear();
+      uint8_t value = 0xa5;
+      lcd.send(&value, 1, mode);
+
+      uint8_t rsBit = mode ? PCF8574_LCD_RS : 0;
+      uint8_t control = rsBit | (backlight ? PCF8574_LCD_BACKLIGHT : 0);
+      uint8_t expected[] = {
+          control,
+          (uint8_t)(0xa0 | control | PCF8574_LCD_ENABLE),
+          (uint8_t)(0xa0 | control),
+          (uint8_t)(0x50 | control | PCF8574_LCD_ENABLE),
+          (uint8_t)(0x50 | control),
+      };
+      TEST_ASSERT_EQUAL(1, lcd.transfers);
+      TEST_ASSERT_EQUAL(sizeof(expected), lcd.count);
+      TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, lcd.bytes, sizeof(expected));
+    }
+  }
+}
+
+// Every nibble is latched once, on a high to low enable edge, in order
+void test_enable_edges() {
+  RecordingPCF8574 lcd;
+  lcd.begin();
+  lcd.clear();
+  const char* text = "Cut 12 of 40, 1234.5mm";
+  int length = strlen(text);
+  lcd.send((const uint8_t*)text, length, HIGH);
+
+  uint8_t nibbles[64];
+  uint8_t rs[64];
+  TEST_ASSERT_EQUAL(2 * length,
+                    latchedNibbles(lcd, nibbles, rs, PCF8574_LCD_BACKLIGHT));
+  for (int i = 0; i < length; i++) {
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)text[i] >> 4, nibbles[2 * i]);
+    TEST_ASSERT_EQUAL_HEX8(text[i] & 0xf, nibbles[2 * i + 1]);
+    TEST_ASSERT_EQUAL_HEX8(PCF8574_LCD_RS, rs[2 * i]);
+    TEST_ASSERT_EQUAL_HEX8(PCF8574_LCD_RS, rs[2 * i + 1]);
+  }
+}
+
+// 7 characters fit in a transfer of 32 bytes: the RS byte and 4 per character
+void test_batching() {
+  RecordingPCF8574 lcd;
+  lcd.begin();
+  const int perTransfer = (PCF8574_LCD_TRANSFER - 1) / 4;
+  TEST_ASSERT_EQUAL(7, perTransfer);
+
+  uint8_t text[20];
+  for (int length = 1; length <= 20; length++) {
+    for (int i = 0; i < length; i++) text[i] = 'A' + i;
+    lcd.clear();
+    lcd.send(text, length, HIGH);
+
+    int transfers = (length + perTransfer - 1) / perTransfer;
+    TEST_ASSERT_EQUAL(transfers, lcd.transfers);
+    TEST_ASSERT_EQUAL(length * 4 + transfers, lcd.count);
+    int start = 0;
+    for (int t = 0; t < transfers; t++) {
+      int chars = (t + 1 < transfers) ? perTransfer : length - t * perTransfer;
+      TEST_ASSERT_EQUAL(1 + 4 * chars, lcd.transferEnd[t] - start);
+      TEST_ASSERT_EQUAL_HEX8(PCF8574_LCD_BACKLIGHT | PCF8574_LCD_RS,
+                             lcd.bytes[start]);  // RS before any edge
+      start = lcd.transferEnd[t];
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_write4bits);
+  RUN_TEST(test_packing);
+  RUN_TEST(test_enable_edges);
+  RUN_TEST(test_batching);
+  return UNITY_END();
+}
@@ -0,0 +1,11 @@
+// AccelStepper with the fixed-point ramp, renamed so it links beside the float build
+#define ACCELSTEPPER_FIXED_POINT
+#define AccelStepper AccelStepperFixed
+#define AccelStepperCore AccelStepperCoreFixed
+#include "../../lib/AccelStepper/src/AccelStepper.cpp"
+
+#include "ramp_trace.h"
+
+#define RAMP_MOVE rampMoveFixed
+#define RAMP_STOP rampStopFixed
+#include "ramp_run.h"
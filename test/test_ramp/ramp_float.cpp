@@ -0,0 +1,10 @@
+// AccelStepper with the float ramp, renamed so it links beside the fixed-point build
+#define AccelStepper AccelStepperFloat
+#define AccelStepperCore AccelStepperCoreFloat
+#include "../../lib/AccelStepper/src/AccelStepper.cpp"
+
+#include "ramp_trace.h"
+
+#define RAMP_MOVE rampMoveFloat
+#define RAMP_STOP rampStopFloat
+#include "ramp_run.h"
@@ -0,0 +1,40 @@
+// Runs moves through whichever build of AccelStepper was included before this
+// file. Each build defines RAMP_MOVE and RAMP_STOP to its own function names.
+
+static void noStep() {}
+
+long RAMP_MOVE(const RampMove& move, unsigned long* intervals, long maxSteps) {
+  AccelStepper stepper(noStep, noStep);
+  stepper.setMaxSpeed(move.maxSpeed);
+  stepper.setAcceleration(move.acceleration);
+  fakeMicros = 0;
+  stepper.moveTo(move.distance);
+
+  long steps = 0;
+  unsigned long lastStep = 0;
+  while (stepper.distanceToGo() != 0 && steps < maxSteps) {
+    fakeMicros++;
+    long position = stepper.currentPosition();
+    stepper.run();
+    if (stepper.currentPosition() != position) {
+      intervals[steps++] = fakeMicros - lastStep;
+      lastStep = fakeMicros;
+    }
+  }
+  return steps;
+}
+
+long RAMP_STOP(const RampMove& move, long stopAfter) {
+  AccelStepper stepper(noStep, noStep);
+  stepper.setMaxSpeed(move.maxSpeed);
+  stepper.setAcceleration(move.acceleration);
+  fakeMicros = 0;
+  stepper.moveTo(move.distance);
+
+  while (stepper.currentPosition() < stopAfter) {
+    fakeMicros++;
+    stepper.run();
+  }
+  stepper.stop();
+  return stepper.targetPosition();
+}
@@ -0,0 +1,26 @@
+#ifndef RAMP_TRACE_H
+#define RAMP_TRACE_H
+
+// AccelStepper is built twice for this test, once with the float ramp and once
+// with ACCELSTEPPER_FIXED_POINT, under the class names AccelStepperFloat and
+// AccelStepperFixed. These functions run the same move through each.
+
+struct RampMove {
+  float maxSpeed;      // steps/s
+  float acceleration;  // steps/s^2
+  long distance;       // steps, from rest at 0
+};
+
+// Runs move to the end and records the time in microseconds before each step.
+// Returns the number of steps taken.
+long rampMoveFloat(const RampMove& move, unsigned long* intervals,
+                   long maxSteps);
+long rampMoveFixed(const RampMove& move, unsigned long* intervals,
+                   long maxSteps);
+
+// Calls stop() once the stepper gets to stopAfter and returns the new target,
+// which is where stop() worked out the stepper will come to rest.
+long rampStopFloat(const RampMove& move, long stopAfter);
+long rampStopFixed(const RampMove& move, long stopAfter);
+
+#endif  // RAMP_TRACE_H
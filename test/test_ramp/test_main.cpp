@@ -0,0 +1,99 @@
+#include <unity.h>
+
+#include "ramp_trace.h"
+
+unsigned long fakeMicros;
+
+// The fixed-point ramp rounds each step of Equation 13 to the nearest
+// fraction of a microsecond where the float ramp keeps every bit, so an
+// interval may come out one microsecond the other side of a whole number.
+// Rounding has to be unbiased in both directions, or the error builds up over
+// a ramp: the whole move must take the same time to within a few intervals'
+// worth of rounding. The two must also agree on where to start slowing down
+// and where a stop() comes to rest.
+const unsigned long intervalTolerance = 1;  // us
+const unsigned long moveTimeTolerance = 10;  // us
+const long stepTolerance = 1;
+
+const long maxSteps = 20000;
+static unsigned long floatIntervals[maxSteps];
+static unsigned long fixedIntervals[maxSteps];
+
+void setUp() {}
+void tearDown() {}
+
+// First step that takes longer than the one before it
+static long decelerationStart(const unsigned long* intervals, long steps) {
+  for (long i = 1; i < steps; i++)
+    if (intervals[i] > intervals[i - 1]) return i;
+  return steps;
+}
+
+static void compareMove(const RampMove& move) {
+  long floatSteps = rampMoveFloat(move, floatIntervals, maxSteps);
+  long fixedSteps = rampMoveFixed(move, fixedIntervals, maxSteps);
+  TEST_ASSERT_EQUAL(move.distance, floatSteps);
+  TEST_ASSERT_EQUAL(move.distance, fixedSteps);
+
+  unsigned long floatTime = 0;
+  unsigned long fixedTime = 0;
+  for (long i = 0; i < move.distance; i++) {
+    TEST_ASSERT_UINT32_WITHIN(intervalTolerance, floatIntervals[i],
+                              fixedIntervals[i]);
+    floatTime += floatIntervals[i];
+    fixedTime += fixedIntervals[i];
+  }
+  TEST_ASSERT_UINT32_WITHIN(moveTimeTolerance, floatTime, fixedTime);
+
+  TEST_ASSERT_INT32_WITHIN(stepTolerance,
+                           decelerationStart(floatIntervals, floatSteps),
+                           decelerationStart(fixedIntervals, fixedSteps));
+}
+
+static void compareStop(const RampMove& move, long stopAfter) {
+  TEST_ASSERT_INT32_WITHIN(stepTolerance, rampStopFloat(move, stopAfter),
+                           rampStopFixed(move, stopAfter));
+}
+
+// Reaches max speed: accelerate, cruise, decelerate
+static void test_feed_move() {
+  RampMove move = {500, 100, 3000};
+  compareMove(move);
+}
+
+static void test_fast_move() {
+  RampMove move = {4000, 20000, 10000};
+  compareMove(move);
+}
+
+static void test_long_deceleration() {
+  RampMove move = {2000, 1000, 5000};
+  compareMove(move);
+}
+
+// Too short to reach max speed: accelerate then straight into decelerate
+static void test_short_move() {
+  RampMove move = {1000, 500, 300};
+  compareMove(move);
+}
+
+static void test_stop_while_accelerating() {
+  RampMove move = {500, 100, 3000};
+  compareStop(move, 300);
+}
+
+static void test_stop_while_cruising() {
+  RampMove move = {500, 100, 3000};
+  compareStop(move, 1500);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_feed_move);
+  RUN_TEST(test_fast_move);
+  RUN_TEST(test_long_deceleration);
+  RUN_TEST(test_short_move);
+  RUN_TEST(test_stop_while_accelerating);
+  RUN_TEST(test_stop_while_cruising);
+  return UNITY_END();
+}
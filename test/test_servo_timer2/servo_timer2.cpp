@@ -0,0 +1,5 @@
+// The AVR Servo library driven from Timer2, running on the model in timer2_model.h
+#define ARDUINO_ARCH_AVR
+#define SERVO_USE_TIMER2
+#include "timer2_model.h"
+#include "../../lib/Servo/src/avr/Servo.cpp"
@@ -0,0 +1,107 @@
+#include <unity.h>
+
+#define ARDUINO_ARCH_AVR
+#define SERVO_USE_TIMER2
+#include <Servo.h>
+
+#include "timer2_model.h"
+
+unsigned long fakeMicros;
+unsigned long timer2Ticks;
+uint8_t timer2ReadCost;
+Timer2Counter TCNT2;
+Timer2Flags TIFR2;
+volatile uint8_t OCR2A, TCCR2A, TCCR2B, TIMSK2, SREG;
+volatile uint8_t servoPort;
+
+void timer2Advance(unsigned long ticks) {
+  while (ticks--) {
+    timer2Ticks++;
+    if ((uint8_t)timer2Ticks == OCR2A) TIFR2.flags |= _BV(OCF2A);
+  }
+}
+
+Timer2Counter::operator uint8_t() {
+  timer2Advance(timer2ReadCost);
+  return (uint8_t)timer2Ticks;
+}
+
+Timer2Counter& Timer2Counter::operator=(uint8_t value) {
+  timer2Ticks = (timer2Ticks & ~0xffUL) | value;
+  return *this;
+}
+
+const uint8_t servoPin = 5;
+const uint8_t interruptLatency = 3;  // ticks from the match to the handler
+const long edgeTolerance = 8;        // ticks of handler time either side
+
+static Servo servo;
+
+void setUp() {}
+void tearDown() {}
+
+// Runs the timer for frames refresh periods and checks that every pulse is
+// ticks long and every period starts refreshInterval() after the one before.
+// Timing is taken from the interrupts, as the edges are written in them.
+static void checkPulses(uint16_t ticks, int frames) {
+  servo.writeTicks(ticks);
+  long period = (long)servo.refreshInterval() * 2;
+  unsigned long end = timer2Ticks + (frames + 1) * (unsigned long)period;
+  unsigned long rise = 0;
+  bool high = servoPort & _BV(servoPin);
+  bool risen = false;
+  bool settled = false;  // past the first pulse, which may have the old width
+
+  while (timer2Ticks < end) {
+    timer2Advance(1);
+    if (!(TIFR2 & _BV(OCF2A))) continue;
+    TIFR2 = _BV(OCF2A);
+    unsigned long at = timer2Ticks;
+    timer2Advance(interruptLatency);
+    TIMER2_COMPA_vect();
+
+    bool now = servoPort & _BV(servoPin);
+    if (now && !high) {
+      if (settled && risen)
+        TEST_ASSERT_INT32_WITHIN(edgeTolerance, period, at - rise);
+      rise = at;
+      risen = true;
+    } else if (!now && high) {
+      if (settled) TEST_ASSERT_INT32_WITHIN(edgeTolerance, ticks, at - rise);
+      settled = true;
+    }
+    high = now;
+  }
+  TEST_ASSERT_TRUE(settled && risen);
+}
+
+// Pulses a few ticks either side of whole 256 tick wraps, so that the first
+// compare match of the last wrap is only a few ticks after the interrupt that
+// sets it up, and can come before or after the OCR2A write
+static void checkNearWraps(uint8_t readCost) {
+  timer2ReadCost = readCost;
+  for (uint16_t wraps = 4; wraps <= 18; wraps++)
+    for (int offset = -6; offset <= 10; offset++)
+      checkPulses(wraps * 256 + offset, 2);
+}
+
+static void test_pulses_near_wraps_fast_reads() { checkNearWraps(1); }
+
+static void test_pulses_near_wraps_slow_reads() { checkNearWraps(2); }
+
+static void test_pulses_near_wraps_slower_reads() { checkNearWraps(3); }
+
+static void test_pulse_mid_wrap() {
+  timer2ReadCost = 1;
+  checkPulses(3000, 4);
+}
+
+int main() {
+  UNITY_BEGIN();
+  servo.attach(servoPin);
+  RUN_TEST(test_pulses_near_wraps_fast_reads);
+  RUN_TEST(test_pulses_near_wraps_slow_reads);
+  RUN_TEST(test_pulses_near_wraps_slower_reads);
+  RUN_TEST(test_pulse_mid_wrap);
+  return UNITY_END();
+}
@@ -0,0 +1,48 @@
+#ifndef TIMER2_MODEL_H
+#define TIMER2_MODEL_H
+
+#include <stdint.h>
+
+// The parts of an ATmega328 the Timer2 servo backend touches. Timer2 counts
+// timer2Ticks, and every read of TCNT2 costs timer2ReadCost ticks, which is how
+// the counter gets past OCR2A while the interrupt handler is still setting it.
+
+extern unsigned long timer2Ticks;
+extern uint8_t timer2ReadCost;
+
+// Counts the timer on, raising OCF2A as the counter meets OCR2A
+void timer2Advance(unsigned long ticks);
+
+struct Timer2Counter {
+  operator uint8_t();
+  Timer2Counter& operator=(uint8_t value);
+};
+
+// Flags are cleared by writing a 1 to them
+struct Timer2Flags {
+  uint8_t flags;
+  operator uint8_t() const { return flags; }
+  Timer2Flags& operator=(uint8_t value) {
+    flags &= ~value;
+    return *this;
+  }
+};
+
+extern Timer2Counter TCNT2;
+extern Timer2Flags TIFR2;
+extern volatile uint8_t OCR2A, TCCR2A, TCCR2B, TIMSK2, SREG;
+extern volatile uint8_t servoPort;
+
+#define _BV(bit) (1 << (bit))
+#define CS21 1
+#define OCF2A 1
+#define OCIE2A 1
+
+#define clockCyclesPerMicrosecond() 16
+#define digitalPinToPort(pin) 0
+#define digitalPinToBitMask(pin) _BV(pin)
+#define portOutputRegister(port) (&servoPort)
+
+extern "C" void TIMER2_COMPA_vect(void);
+
+#endif  // TIMER2_MODEL_H